@@ -76,3 +76,24 @@ function(target_link_test_utils target_name)
   target_link_libraries(${target_name} PUBLIC test_utils)
 endfunction()
 
+
+# -----------------------------------------------------------------------------
+# join_utils (host side helpers shared by the join harnesses)
+# -----------------------------------------------------------------------------
+set(JOIN_UTILS_DIR "${CMAKE_CURRENT_LIST_DIR}/join_utils")
+
+function(target_link_join_utils target_name)
+  find_package(Threads REQUIRED)
+  target_include_directories(${target_name} PUBLIC "${JOIN_UTILS_DIR}")
+  target_link_libraries(${target_name} PUBLIC Threads::Threads)
+endfunction()
+
+# Compiles AIE kernel sources into a host target against the host emulation
+# of aie_objectfifo.h (join_utils/host_aie), used by the cpu backend.
+function(target_add_host_kernels target_name)
+  target_sources(${target_name} PRIVATE ${ARGN})
+  set_source_files_properties(${ARGN} PROPERTIES
+    LANGUAGE CXX
+    COMPILE_DEFINITIONS AIE_HOST_EMULATION)
+  target_include_directories(${target_name} PUBLIC "${JOIN_UTILS_DIR}/host_aie")
+endfunction()
@@ -0,0 +1,9 @@
+#measured iterations per point for the percentiles, ./collect.sh 1 for a quick pass
+iters=${1:-100}
+rm -f bench_xchesscc.csv bench_xchesscc.json
+#the design only depends on the block size, it is built once
+make clean
+for elements in 16384 32768 65536 131072 262144 524288 1048576
+do
+    make run_xchesscc benchIters=${iters} sizeA=${elements}
+done
@@ -0,0 +1,344 @@
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <set>
+#include<unordered_map>
+
+
+#include "cxxopts.hpp"
+#include "test_utils.h"
+#include "hash_join.h"
+#include "bench.h"
+#include "datagen.h"
+#include "join_verify.h"
+#include "chunked_join.h"
+#include "result_store.h"
+#include "exec_backend.h"
+#include "host_emu.h"
+
+#ifndef JOIN_NO_XRT
+#include "xrt_backend.h"
+#include "xrt/xrt_graph.h"
+#endif
+
+
+#ifndef DATATYPES_USING_DEFINED
+#define DATATYPES_USING_DEFINED
+using DATATYPE = std::int32_t;
+#endif
+
+
+uint32_t getParity(uint32_t n) {
+  int count = 0;
+  while (n > 0) {
+    if (n & 1) { // Check if the least significant bit is 1
+      count++;
+    }
+    n >>= 1; // Right shift to check the next bit
+  }
+  return (count % 2 == 0) ? 0 : 1; // 0 for even parity, 1 for odd parity
+}
+
+uint32_t create_ctrl_pkt(int operation, int beats, int addr,
+                         int ctrl_pkt_read_id = 28) {
+  uint32_t ctrl_pkt = ((ctrl_pkt_read_id & 0xFF) << 24) |
+                      ((operation & 0x3) << 22) | ((beats & 0x3) << 20) |
+                      (addr & 0x7FFFF);
+  ctrl_pkt |= (0x1 ^ getParity(ctrl_pkt)) << 31;
+  return ctrl_pkt;
+}
+
+int main(int argc, const char *argv[]) {
+  // Program arguments parsing
+  cxxopts::Options options("odd_even Kernel");
+  test_utils::add_default_options(options);
+  options.add_option("","e","host_elements", "block size of A the design was built for (assumed to be 4 bytes)",
+      cxxopts::value<int64_t>()->default_value("1024"),"host elements");
+
+  options.add_option("","","block_b", "block size of B the design was built for, 0 means host_elements, must match aie2.py",
+      cxxopts::value<int64_t>()->default_value("0"),"block b");
+
+  options.add_option("","","size_a", "elements of the outer relation A, any size, 0 means host_elements",
+      cxxopts::value<int64_t>()->default_value("0"),"size a");
+
+  options.add_option("","","size_b", "elements of the inner relation B, any size, 0 means size_a",
+      cxxopts::value<int64_t>()->default_value("0"),"size b");
+
+  options.add_option("","","resident_mb", "results kept in memory before the result store spills to a temporary file",
+      cxxopts::value<int64_t>()->default_value("1024"),"resident MB");
+
+  options.add_option("","d","dist", "key domain, keys are drawn from 1 .. dist (uniform, zipf, no_match), selectivity 1/dist by default",
+      cxxopts::value<int32_t>()->default_value("100"),"distribution value");
+
+  options.add_option("","","key_dist", "key distribution: uniform, zipf, foreign_key, selectivity, all_equal, no_match",
+      cxxopts::value<std::string>()->default_value("uniform"),"key distribution");
+
+  options.add_option("","","selectivity", "join selectivity of --key_dist=selectivity, 0 means 1/dist",
+      cxxopts::value<double>()->default_value("0"),"selectivity");
+
+  options.add_option("","","zipf_s", "skew of --key_dist=zipf",
+      cxxopts::value<double>()->default_value("1.0"),"zipf exponent");
+
+  options.add_option("","","seed", "seed of the input generator",
+      cxxopts::value<uint64_t>()->default_value("12345"),"seed");
+
+  options.add_option("","b","backend", "execution backend: xrt or cpu (host emulation of the design)",
+      cxxopts::value<std::string>()->default_value("xrt"),"backend");
+
+  options.add_option("","","variant", "design name the benchmark record is tagged with",
+      cxxopts::value<std::string>()->default_value("join_new_chunked"),"variant");
+
+  options.add_option("","","compiler", "kernel compiler the benchmark record is tagged with (peano, xchesscc, cpu)",
+      cxxopts::value<std::string>()->default_value("unknown"),"compiler");
+
+  options.add_option("","","bench_csv", "CSV file the benchmark record is appended to, empty for none",
+      cxxopts::value<std::string>()->default_value("bench.csv"),"bench csv");
+
+  options.add_option("","","bench_json", "file the benchmark record is appended to as a JSON line, empty for none",
+      cxxopts::value<std::string>()->default_value(""),"bench json");
+
+  cxxopts::ParseResult vm;
+  test_utils::parse_options(argc, argv, options, vm);
+  int verbosity = vm["verbosity"].as<int>();
+  int n_iterations = vm["iters"].as<int>();
+  int n_warmup_iterations = vm["warmup"].as<int>();
+  int trace_size = vm["trace_sz"].as<int>();
+
+  join_utils::DataGenConfig gen_config;
+  gen_config.domain = vm["dist"].as<int>();
+  gen_config.dist = join_utils::parse_key_dist(vm["key_dist"].as<std::string>());
+  gen_config.selectivity = vm["selectivity"].as<double>();
+  gen_config.zipf_s = vm["zipf_s"].as<double>();
+  gen_config.seed = vm["seed"].as<uint64_t>();
+  std::string backend_name = vm["backend"].as<std::string>();
+
+  // Declaring design constants
+  constexpr bool VERIFY = true;
+  //one launch only joins a block pair, so neither the 1GB output buffer nor
+  //the launch timeout limit the relation sizes any more
+  int64_t host_elements = vm["host_elements"].as<int64_t>();
+   std::cout << "host_elements: " << host_elements << "\n";
+  join_utils::ChunkedJoinConfig config;
+  config.block_a = host_elements;
+  config.block_b = vm["block_b"].as<int64_t>() > 0 ? vm["block_b"].as<int64_t>() : host_elements;
+  int64_t IN_SIZE_A = vm["size_a"].as<int64_t>() > 0 ? vm["size_a"].as<int64_t>() : host_elements;
+  int64_t IN_SIZE_B = vm["size_b"].as<int64_t>() > 0 ? vm["size_b"].as<int64_t>() : IN_SIZE_A;
+  size_t resident_bytes = (size_t)vm["resident_mb"].as<int64_t>() << 20;
+  std::cout << "size_a: " << IN_SIZE_A << " size_b: " << IN_SIZE_B
+            << " blocks: " << config.block_a << " x " << config.block_b << "\n";
+  //the chunks are whole launches, a trace would only show the last one
+  if (trace_size > 0)
+    std::cout << "tracing is not supported by the chunked driver, trace_sz ignored\n";
+
+
+  std::unique_ptr<join_utils::ExecBackend> backend;
+  if (backend_name == "cpu") {
+    //same tiling as aie2.py, the cores run as host threads. The host
+    //emulation has one lock table, so overlapping launches run one by one
+    auto emu_m = std::make_shared<std::mutex>();
+    int64_t block_a = config.block_a, block_b = config.block_b;
+    int64_t out_words = join_utils::chunk_out_words(block_a, block_b);
+    backend = std::make_unique<join_utils::CpuBackend>(
+        [emu_m, block_a, block_b, out_words](const std::vector<join_utils::Buffer *> &args) {
+          std::lock_guard<std::mutex> lk(*emu_m);
+          HostEmuStats stats;
+          bool ok = run_join_design_on_host(
+              args[0]->map<DATATYPE>(), block_a, args[1]->map<DATATYPE>(),
+              block_b, args[2]->map<DATATYPE>(), out_words,
+              args[3]->map<uint32_t>(), &stats);
+          if (!ok)
+            std::cout << "host emulation failed: " << stats.error << "\n";
+          return ok;
+        });
+  } else {
+#ifndef JOIN_NO_XRT
+    // Load instruction sequence
+    std::vector<uint32_t> instr_v =
+        test_utils::load_instr_binary(vm["instr"].as<std::string>());
+
+    if (verbosity >= 1)
+      std::cout << "Sequence instr count: " << instr_v.size() << "\n";
+
+    // Start the XRT context and load the kernel
+    backend = std::make_unique<join_utils::XrtBackend>(
+        verbosity, vm["xclbin"].as<std::string>(),
+        vm["kernel"].as<std::string>(), instr_v);
+#else
+    std::cout << "built without XRT, only --backend=cpu is available\n";
+    return 1;
+#endif
+  }
+  std::cout << "backend: " << backend->name() << "\n";
+
+  // two slots of block sized buffer objects, see chunked_join.h
+  join_utils::ChunkedJoin<DATATYPE> driver(*backend, config);
+  std::cout << "out buffer per launch: " << driver.out_words() << " elements\n";
+
+  std::vector<DATATYPE> bufInA(IN_SIZE_A), bufInB(IN_SIZE_B);
+  join_utils::ResultStore<DATATYPE> results(size_t(1) << 20, resident_bytes);
+
+
+  // Execute the kernel and wait to finish
+  int errors = 0;
+  unsigned num_iter = n_iterations + n_warmup_iterations;
+  join_utils::Bench bench(n_warmup_iterations);
+  float npu_time_total = 0;
+  float npu_time_min = 9999999;
+  float npu_time_max = 0;
+  float selectivi = 0;
+
+  float cpu_time_total = 0;
+
+
+
+  //keys are generated by all host threads straight into the inputs, a new
+  //set every iteration
+  join_utils::DataGen<DATATYPE> datagen(gen_config);
+
+
+  for (int iter = 0; iter < num_iter; iter++) {
+    //todo put back warmup iterrations
+     std::cout << "iter: " << iter <<"\n";
+
+      if (verbosity >= 1) {
+      std::cout << "Setting inputs ..." << std::endl;
+    }
+
+      datagen.fill(bufInA.data(), IN_SIZE_A, bufInB.data(), IN_SIZE_B, iter);
+
+      results.clear();
+
+
+    std::cout << "Running Kernel.\n";
+
+    join_utils::ChunkedJoinStats stats;
+    bool completed = driver.run(bufInA.data(), IN_SIZE_A, bufInB.data(),
+                                IN_SIZE_B, results, &stats);
+    if (!completed) {
+      std::cout << "chunked join failed: " << stats.error << "\n";
+      errors++;
+    }
+
+    std::cout << "launches: " << stats.launches << " results: " << stats.results
+              << " spilled: " << stats.spilled_bytes / (1 << 20) << "MB"
+              << " waiting: " << stats.wait_seconds * 1e6 << "us\n";
+
+    float npu_time = stats.seconds * 1e6;
+    std::cout << ""
+              << "NPU time: " << npu_time << "us."
+              << std::endl;
+
+  if (iter < n_warmup_iterations)
+      /* Warmup iterations do not count towards average runtime. */
+      continue;
+
+    npu_time_total += npu_time;
+    bench.add_npu(iter, npu_time);
+    npu_time_min = (npu_time < npu_time_min) ? npu_time : npu_time_min;
+    npu_time_max = (npu_time > npu_time_max) ? npu_time : npu_time_max;
+
+    // Compare out to golden
+
+    if(VERIFY && completed){
+        if (verbosity >= 1) {
+            std::cout << "Verifying results ..." << std::endl;
+        }
+
+
+        auto start = std::chrono::high_resolution_clock::now();
+        join_utils::JoinResult<DATATYPE> ref = join_utils::radix_hash_join(
+            bufInA.data(), IN_SIZE_A, bufInB.data(), IN_SIZE_B, false);
+         auto stop = std::chrono::high_resolution_clock::now();
+         float cpu_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(stop - start)
+            .count();
+          std::cout << ""
+              << "CPU time: " << cpu_time << "us."
+              << std::endl;
+          cpu_time_total += cpu_time;
+          bench.add_cpu(iter, cpu_time);
+
+        size_t ref_size = 0;
+        for (auto &kv : ref.histogram)
+            ref_size += kv.second;
+         std::cout << ""
+              << "ref.size(): " << ref_size << ""
+              << std::endl;
+         std::cout << ""
+              << "selectivity: " << (double)ref_size / ((double)IN_SIZE_A*IN_SIZE_B) << ""
+              << std::endl;
+        selectivi = (double)ref_size / ((double)IN_SIZE_A*IN_SIZE_B);
+
+        join_utils::VerifyResult<DATATYPE> check = join_utils::verify_join_segments(
+            [&](auto fn) { results.for_each_segment(fn); }, ref.histogram);
+
+        if(check.equal){
+            std::cout << "equal"<< "\n";
+        }else{
+            std::cout << "not equal"<< "\n";
+            std::cout << "first differing key: " << check.key
+                      << " expected: " << check.expected
+                      << " got: " << check.got << "\n";
+            errors++;
+        }
+
+
+
+
+    }
+
+
+
+
+  }
+
+  // print out profiling result
+  std::cout << std::endl
+          << "Number of iterations: " << n_iterations
+          << " (warmup iterations: " << n_warmup_iterations << ")"
+          << std::endl;
+
+  std::cout << std::endl
+            << "Avg NPU time: " << npu_time_total / n_iterations << "us."
+            << std::endl;
+
+std::cout << std::endl
+            << "Avg CPU time: " << cpu_time_total / n_iterations << "us."
+            << std::endl;
+
+
+    join_utils::BenchRecord record;
+    record.variant = vm["variant"].as<std::string>();
+    record.compiler = backend_name == "cpu" ? "cpu" : vm["compiler"].as<std::string>();
+    record.backend = backend->name();
+    record.size_a = IN_SIZE_A;
+    record.size_b = IN_SIZE_B;
+    record.selectivity = selectivi;
+    record.cores = 2;
+    record.results = (uint64_t)std::llround(selectivi * (double)IN_SIZE_A * (double)IN_SIZE_B);
+    record.bytes = (IN_SIZE_A + IN_SIZE_B + record.results) * sizeof(DATATYPE);
+    record.warmup = n_warmup_iterations;
+    record.npu = bench.npu();
+    record.cpu = bench.cpu();
+    join_utils::bench_print(std::cout, record);
+    if (!join_utils::bench_append_csv(vm["bench_csv"].as<std::string>(), record) ||
+        !join_utils::bench_append_json(vm["bench_json"].as<std::string>(), record))
+      std::cout << "could not write the benchmark record\n";
+
+  // Print Pass/Fail result of our test
+  if (!errors) {
+    std::cout << std::endl << "PASS!" << std::endl << std::endl;
+
+    return 0;
+  } else {
+    std::cout << std::endl
+              << errors << " mismatches." << std::endl
+              << std::endl;
+    std::cout << std::endl << "fail." << std::endl << std::endl;
+    //return 1;
+  }
+}
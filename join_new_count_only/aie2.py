@@ -0,0 +1,233 @@
+from pkgutil import extend_path
+
+import numpy as np
+import sys
+import aie.utils.trace as trace_utils
+
+from aie.dialects.aie import *
+from aie.dialects.aiex import *
+from aie.helpers.dialects.scf import _for as range_, if_, else_
+from aie.extras.context import mlir_mod_ctx
+from setuptools.archive_util import extraction_drivers
+
+#use stderr so the mlir output does not break
+#These are don't have to be errors
+def eprint(*args, **kwargs):
+    print(*args, file=sys.stderr, **kwargs)
+
+if len(sys.argv) > 1:
+    if sys.argv[1] == "npu":
+        dev = AIEDevice.npu1
+    elif sys.argv[1] == "npu2":
+        dev = AIEDevice.npu2
+    else:
+        raise ValueError("[ERROR] Device name {} is unknown".format(sys.argv[1]))
+
+trace_size = 0
+if len(sys.argv) > 2:
+    if sys.argv[2].isdigit():
+        trace_size = int(sys.argv[2])
+        eprint("[INFO] trace_size: {}".format(trace_size))
+    else:
+        eprint("[Info] sys.argv[2] (trace_size):{} is not a positive number falling back to trace_size = 0".format(sys.argv[2]))
+
+host_elements = 1024
+if len(sys.argv) > 3:
+    if sys.argv[3].isdigit():
+        host_elements = int(sys.argv[3])
+        eprint("[INFO] host_elements: {}".format(host_elements))
+    else:
+        eprint("[Info] sys.argv[3] (host_elements):{} is not a positive number falling back to host_elements = 1024".format(sys.argv[3]))
+
+
+
+def external_mem_to_core():
+    with mlir_mod_ctx() as ctx:
+
+        @device(dev)
+        def device_body():
+
+            #count only join: the cores only count matching pairs,
+            #no join result is written, the only output is the outdone fifo
+
+            tranfer_size_elemnts_in = host_elements
+
+            eprint("[INFO] tranfer_size_elemnts_in: {}".format(tranfer_size_elemnts_in))
+
+            #A is split over two cores in 128 element chunks, B is broadcast
+            tile_ty_size_in_mem = 128
+            tile_ty_size_in = 64
+
+            eprint("[INFO] tile_ty_size_in: {}".format(tile_ty_size_in))
+
+            #a partial last chunk would be dropped and the count come out too low
+            if host_elements % tile_ty_size_in_mem != 0:
+                raise ValueError("[ERROR] host_elements must be a multiple of {} ({})".format(tile_ty_size_in_mem, host_elements))
+
+            #todo fix for A B different sizes
+            iters_outer = host_elements // tile_ty_size_in // 2
+            #one relation needs to be pushed several times
+            transfers_inner = iters_outer
+
+            # todo fix for A B different sizes
+            iters_inner = host_elements // tile_ty_size_in
+
+            eprint("[INFO] iters_outer: {}".format(iters_outer))
+            eprint("[INFO] iters_inner: {}".format(iters_inner))
+
+            eprint("[INFO] transfers_inner: {}".format(transfers_inner))
+
+            mem_ty_in = np.ndarray[(tile_ty_size_in_mem,), np.dtype[np.int32]]
+            tile_ty_in = np.ndarray[(tile_ty_size_in,), np.dtype[np.int32]]
+
+            data_ty_in = np.ndarray[(tranfer_size_elemnts_in,), np.dtype[np.int32]]
+
+            ty_one_int = np.ndarray[(1,), np.dtype[np.int32]]
+
+            #each core reports its partial count in its half of outdone
+            done_size_core = 8
+            done_ty_core = np.ndarray[(done_size_core,), np.dtype[np.int32]]
+            data_ty_done = np.ndarray[(2 * done_size_core,), np.dtype[np.int32]]
+
+            # External, binary kernel definition
+            odd_even_count = external_func(
+                "odd_even_count",
+                inputs=[tile_ty_in, tile_ty_in, ty_one_int]
+            )
+
+            # Tile declarations
+            ShimTile00 = tile(0, 0)
+            ShimTile20 = tile(2, 0)
+            MemTile01 = tile(0, 1)
+            ComputeTile02 = tile(0, 2)
+            ComputeTile03 = tile(0, 3)
+
+            # AIE-array data movement with object fifos
+            # Input
+            of_in = object_fifo("in", ShimTile00, MemTile01, 2, mem_ty_in)
+
+            of_in1 = object_fifo("in1", MemTile01, ComputeTile02, 2, tile_ty_in)
+            of_in2 = object_fifo("in2", MemTile01, ComputeTile03, 2, tile_ty_in)
+
+            object_fifo_link(of_in, [of_in1, of_in2], [], [0, tile_ty_size_in])
+
+            of_in_inner_sh = object_fifo("in_inner", ShimTile00, MemTile01, 2, tile_ty_in)
+            of_in_inner = object_fifo("in1_inner", MemTile01, [ComputeTile02, ComputeTile03], 2, tile_ty_in)
+            object_fifo_link(of_in_inner_sh, of_in_inner)
+
+            # Output, only the partial counts, joined in the MemTile
+            of_done1 = object_fifo("outdone1", ComputeTile02, MemTile01, 2, done_ty_core)
+            of_done2 = object_fifo("outdone2", ComputeTile03, MemTile01, 2, done_ty_core)
+            of_done = object_fifo("outdone", MemTile01, ShimTile00, 2, data_ty_done)
+            object_fifo_link([of_done1, of_done2], of_done, [0, done_size_core], [])
+
+            join_cnt02 = aie.buffer(
+                tile=ComputeTile02,
+                datatype=ty_one_int,
+                name=f"join_cnt02",
+                initial_value=np.array(0, dtype=np.int32)
+            )
+            join_cnt03 = aie.buffer(
+                tile=ComputeTile03,
+                datatype=ty_one_int,
+                name=f"join_cnt03",
+                initial_value=np.array(0, dtype=np.int32)
+            )
+
+            # Set up compute tiles
+            # Compute tile
+            @core(ComputeTile02, "odd_even.o")
+            def core_body_02():
+
+                for _ in range_(0xFFFFFFFF):
+                    join_cnt02[0] = 0
+                    for _ in range_(iters_outer):
+                        elem_in = of_in1.acquire(ObjectFifoPort.Consume, 1)
+
+                        for _ in range_(iters_inner):
+                            elem_inner = of_in_inner.acquire(ObjectFifoPort.Consume, 1)
+
+                            call(odd_even_count, [elem_in, elem_inner, join_cnt02])
+
+                            of_in_inner.release(ObjectFifoPort.Consume, 1)
+
+                        of_in1.release(ObjectFifoPort.Consume, 1)
+
+                    elem_done = of_done1.acquire(ObjectFifoPort.Produce, 1)
+                    for i in range_(done_size_core):
+                        elem_done[i] = 77
+                    elem_done[0] = join_cnt02[0]
+                    of_done1.release(ObjectFifoPort.Produce, 1)
+
+            @core(ComputeTile03, "odd_even.o")
+            def core_body_03():
+
+                for _ in range_(0xFFFFFFFF):
+                    join_cnt03[0] = 0
+                    for _ in range_(iters_outer):
+                        elem_in = of_in2.acquire(ObjectFifoPort.Consume, 1)
+
+                        for _ in range_(iters_inner):
+                            elem_inner = of_in_inner.acquire(ObjectFifoPort.Consume, 1)
+
+                            call(odd_even_count, [elem_in, elem_inner, join_cnt03])
+
+                            of_in_inner.release(ObjectFifoPort.Consume, 1)
+
+                        of_in2.release(ObjectFifoPort.Consume, 1)
+
+                    elem_done = of_done2.acquire(ObjectFifoPort.Produce, 1)
+                    for i in range_(done_size_core):
+                        elem_done[i] = 77
+                    elem_done[0] = join_cnt03[0]
+                    of_done2.release(ObjectFifoPort.Produce, 1)
+
+
+            tiles_to_trace = [ComputeTile02, ComputeTile03]
+            if trace_size > 0:
+                trace_utils.configure_packet_tracing_flow(tiles_to_trace, ShimTile20)
+
+
+            #no output tensor, the done buffer is the third argument
+            @runtime_sequence(data_ty_in, data_ty_in, data_ty_done)
+            def sequence(inTensor, innerinTensor, doneTensor):
+
+                if trace_size > 0:
+                    trace_utils.configure_packet_tracing_aie2(
+                        tiles_to_trace=tiles_to_trace,
+                        shim=ShimTile20,
+                        ddr_id=3,# 3 -> group_id(6)
+                        trace_size=trace_size,
+                    )
+
+                in_task = shim_dma_single_bd_task(of_in, inTensor, offset= 0 ,sizes=[1, 1, 1, tranfer_size_elemnts_in],issue_token=False)
+
+                done_task = shim_dma_single_bd_task(
+                    of_done, doneTensor, offset=0, sizes=[1, 1, 1, 2 * done_size_core], issue_token=True, burst_length=64
+                )
+
+                dma_start_task(in_task, done_task)
+
+                for i in range(transfers_inner):
+                    inner_in_task1 = shim_dma_single_bd_task(of_in_inner_sh, innerinTensor, offset=0,
+                                                      sizes=[1, 1, 1, tranfer_size_elemnts_in], issue_token=True)
+
+                    dma_start_task(inner_in_task1)
+                    dma_await_task(inner_in_task1)
+
+
+                dma_await_task(done_task)
+                dma_free_task(in_task)
+
+                if trace_size > 0:
+                    trace_utils.gen_trace_done_aie2(ShimTile20)
+
+
+    res = ctx.module.operation.verify()
+    if res == True:
+        print(ctx.module)
+    else:
+        print(res)
+
+
+external_mem_to_core()
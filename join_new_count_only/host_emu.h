@@ -0,0 +1,64 @@
+//===- host_emu.h -----------------------------------------------*- C++ -*-===//
+//
+// Runs the count only aie2.py design of this directory on the host: the two
+// compute cores become std::threads that call the (scalar model of)
+// odd_even_count on the same tiles the MemTile hands them. core_body_02 gets
+// the even 64 element tiles of A, core_body_03 the odd ones, both see all of
+// B. The fifos only move data here, so the cores read their tiles straight
+// out of a and b.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef HOST_EMU_H
+#define HOST_EMU_H
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+extern "C" {
+void odd_even_count(int32_t *input, int32_t *input1, int32_t *join_count);
+}
+
+// Same constants as aie2.py
+constexpr int32_t HOST_EMU_TILE_IN = 64;
+constexpr int32_t HOST_EMU_CORES = 2;
+constexpr int32_t HOST_EMU_DONE_PER_CORE = 8;
+
+// Counts the matching pairs of a[0 .. host_elements) and b[0 .. host_elements)
+// and fills the 16 words of the outdone fifo like the design does: the
+// partial count of core i at done[i * 8], 77 everywhere else.
+inline bool run_join_design_on_host(const int32_t *a, const int32_t *b,
+                                    int64_t host_elements, uint32_t *done,
+                                    double *seconds = nullptr) {
+  const int64_t tiles = host_elements / HOST_EMU_TILE_IN;
+  if (host_elements % (HOST_EMU_TILE_IN * HOST_EMU_CORES) != 0)
+    return false;
+
+  int32_t join_cnt[HOST_EMU_CORES] = {};
+  auto start = std::chrono::high_resolution_clock::now();
+
+  std::thread cores[HOST_EMU_CORES];
+  for (int32_t c = 0; c < HOST_EMU_CORES; c++)
+    cores[c] = std::thread([&, c]() {
+      for (int64_t i = c; i < tiles; i += HOST_EMU_CORES)
+        for (int64_t j = 0; j < tiles; j++)
+          odd_even_count(const_cast<int32_t *>(a) + i * HOST_EMU_TILE_IN,
+                         const_cast<int32_t *>(b) + j * HOST_EMU_TILE_IN,
+                         &join_cnt[c]);
+    });
+  for (auto &t : cores)
+    t.join();
+
+  for (int i = 0; i < HOST_EMU_CORES * HOST_EMU_DONE_PER_CORE; i++)
+    done[i] = 77;
+  for (int32_t c = 0; c < HOST_EMU_CORES; c++)
+    done[c * HOST_EMU_DONE_PER_CORE] = join_cnt[c];
+
+  auto stop = std::chrono::high_resolution_clock::now();
+  if (seconds)
+    *seconds = std::chrono::duration<double>(stop - start).count();
+  return true;
+}
+
+#endif
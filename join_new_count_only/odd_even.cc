@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <type_traits>
+#ifndef AIE_HOST_EMULATION
+#include <aie_api/aie.hpp>
+#include <aie_api/utils.hpp>
+#endif
+#include "aie_kernel_utils.h"
+
+#ifdef AIE_HOST_EMULATION
+#define restrict __restrict
+#endif
+
+
+
+
+extern "C" {
+
+//count only join, nothing is materialised
+//adds the number of matching pairs of the two 64 element tiles to *join_count
+#ifdef AIE_HOST_EMULATION
+//scalar model of the vector kernel below for the host emulation
+void odd_even_count(int32_t * restrict input, int32_t * restrict input1, int32_t * restrict join_count) {
+   int32_t count = 0;
+   for (int i = 0; i < 64; i++) {
+      for (int j = 0; j < 64; j++) {
+        count += input[i] == input1[j];
+      }
+   }
+   *join_count += count;
+}
+#else
+void odd_even_count(int32_t * restrict input, int32_t * restrict input1, int32_t * restrict join_count) {
+  //event0();
+
+   int32_t count = 0;
+
+   int32_t *__restrict inputv = input;
+
+  AIE_PREPARE_FOR_PIPELINING
+  AIE_LOOP_UNROLL_FULL
+  for (int i = 0; i < 4; i++) {
+        aie::vector<int32_t, 16> A0 = aie::load_v<16>(inputv);
+
+         for (int z = 0; z < 16; z++) {
+            int32_t *__restrict input1v = input1;
+            AIE_LOOP_UNROLL_FULL
+           for (int j = 0; j < 4; j++) {
+
+            aie::vector<int32_t, 16> A1 = aie::load_v<16>(input1v);
+            //popcount of the compare mask, the matches themselves are never written
+            auto mask =  aie::eq(A1,A0[z]);
+            count += mask.count();
+
+            input1v += 16;
+       }
+       }
+       inputv +=16;
+
+}
+ *join_count += count;
+
+//event1();
+}
+#endif
+
+} // extern "C"
@@ -0,0 +1,382 @@
+from pkgutil import extend_path
+
+import numpy as np
+import sys
+import aie.utils.trace as trace_utils
+
+from aie.dialects.aie import *
+from aie.dialects.aiex import *
+from aie.helpers.dialects.scf import _for as range_, if_, else_
+from aie.extras.context import mlir_mod_ctx
+from setuptools.archive_util import extraction_drivers
+
+#use stderr so the mlir output does not break
+#These are don't have to be errors
+def eprint(*args, **kwargs):
+    print(*args, file=sys.stderr, **kwargs)
+
+if len(sys.argv) > 1:
+    if sys.argv[1] == "npu":
+        dev = AIEDevice.npu1
+    elif sys.argv[1] == "npu2":
+        dev = AIEDevice.npu2
+    else:
+        raise ValueError("[ERROR] Device name {} is unknown".format(sys.argv[1]))
+
+trace_size = 0
+if len(sys.argv) > 2:
+    if sys.argv[2].isdigit():
+        trace_size = int(sys.argv[2])
+        eprint("[INFO] trace_size: {}".format(trace_size))
+    else:
+        eprint("[Info] sys.argv[2] (trace_size):{} is not a positive number falling back to trace_size = 0".format(sys.argv[2]))
+
+host_elements = 1024
+if len(sys.argv) > 3:
+    if sys.argv[3].isdigit():
+        host_elements = int(sys.argv[3])
+        eprint("[INFO] host_elements: {}".format(host_elements))
+    else:
+        eprint("[Info] sys.argv[3] (host_elements):{} is not a positive number falling back to host_elements = 1024".format(sys.argv[3]))
+
+#sizes of the outer (A) and inner (B) relation, host_elements is the size of A
+size_a = host_elements
+size_b = host_elements
+if len(sys.argv) > 4:
+    if sys.argv[4].isdigit():
+        size_b = int(sys.argv[4])
+        eprint("[INFO] size_b: {}".format(size_b))
+    else:
+        eprint("[Info] sys.argv[4] (size_b):{} is not a positive number falling back to size_b = host_elements".format(sys.argv[4]))
+
+#keys have to be in [0, domain), the histogram of B lives in the core memory
+domain = 1024
+if len(sys.argv) > 5:
+    if sys.argv[5].isdigit():
+        domain = int(sys.argv[5])
+        eprint("[INFO] domain: {}".format(domain))
+    else:
+        eprint("[Info] sys.argv[5] (domain):{} is not a positive number falling back to domain = 1024".format(sys.argv[5]))
+if domain > 8192:
+    raise ValueError("[ERROR] the histogram of {} keys does not fit the core memory, max is 8192".format(domain))
+
+#1: writeout expands the (key, count) pairs into count copies of the key,
+#0: the pairs themselves are the output
+expand = 1
+if len(sys.argv) > 6:
+    if sys.argv[6].isdigit():
+        expand = int(sys.argv[6])
+        eprint("[INFO] expand: {}".format(expand))
+    else:
+        eprint("[Info] sys.argv[6] (expand):{} is not a positive number falling back to expand = 1".format(sys.argv[6]))
+
+
+
+def external_mem_to_core():
+    with mlir_mod_ctx() as ctx:
+
+        @device(dev)
+        def device_body():
+
+
+
+
+
+            tile_ty_size_in = 64
+
+            #the host pads both relations to whole tiles, the last tile of
+            #each only has tail_a / tail_b valid elements
+            tiles_a = -(-size_a // tile_ty_size_in)
+            tiles_b = -(-size_b // tile_ty_size_in)
+            tail_a = size_a % tile_ty_size_in
+            tail_b = size_b % tile_ty_size_in
+
+            tranfer_size_elemnts_a = tiles_a * tile_ty_size_in
+            tranfer_size_elemnts_b = tiles_b * tile_ty_size_in
+            #A and B are streamed once each
+            #one GB
+            tranfer_size_elemnts_out = (268435456)
+
+
+            eprint("[INFO] tranfer_size_elemnts_a: {}".format(tranfer_size_elemnts_a))
+            eprint("[INFO] tranfer_size_elemnts_b: {}".format(tranfer_size_elemnts_b))
+            eprint("[INFO] tranfer_size_elemnts_out: {}".format(tranfer_size_elemnts_out))
+
+
+            #eprint("[INFO] transfer size in KB: {}".format(tranfer_size_elemnts_in*4/1024))
+
+
+            #elements = 4096
+
+            #one (key, count) pair per key of the outer tile
+            tile_ty_size_trans = 2 * tile_ty_size_in
+            tile_ty_size_out = tile_ty_size_in * tile_ty_size_in
+
+            eprint("[INFO] tile_ty_size_in: {}".format(tile_ty_size_in))
+            eprint("[INFO] tile_ty_size_out: {}".format(tile_ty_size_out))
+
+            #full tiles, the tail tiles are extra calls after the loops
+            iters_outer = size_a // tile_ty_size_in
+            iters_inner = size_b // tile_ty_size_in
+
+            eprint("[INFO] iters_outer: {} tail_a: {}".format(iters_outer, tail_a))
+            eprint("[INFO] iters_inner: {} tail_b: {}".format(iters_inner, tail_b))
+
+
+            tile_ty_in = np.ndarray[(tile_ty_size_in,), np.dtype[np.int32]]
+            tile_ty_trans = np.ndarray[(tile_ty_size_trans,), np.dtype[np.int32]]
+            tile_ty_out = np.ndarray[(tile_ty_size_out,), np.dtype[np.int32]]
+            hist_ty = np.ndarray[(domain,), np.dtype[np.int32]]
+
+            #buffer_ty = np.ndarray[(elements,), np.dtype[np.int32]]
+
+            data_ty_a = np.ndarray[(tranfer_size_elemnts_a,), np.dtype[np.int32]]
+            data_ty_b = np.ndarray[(tranfer_size_elemnts_b,), np.dtype[np.int32]]
+            data_ty_out = np.ndarray[(tranfer_size_elemnts_out,), np.dtype[np.int32]]
+
+            elms_produced_ty = np.ndarray[(1,), np.dtype[np.int32]]
+
+            # External, binary kernel definition
+            hist_clear = external_func(
+                "hist_clear",
+                inputs=[hist_ty, np.int32]
+            )
+            hist_build = external_func(
+                "hist_build",
+                inputs=[tile_ty_in, np.int32, hist_ty, np.int32]
+            )
+            hist_probe = external_func(
+                "hist_probe",
+                inputs=[tile_ty_in, np.int32, hist_ty, np.int32, tile_ty_trans, elms_produced_ty]
+            )
+
+            passThroughLine = external_func(
+                "passThroughLine",
+                inputs=[tile_ty_out, tile_ty_out, np.int32]
+            )
+
+            writeout = external_func(
+                "writeout_expand" if expand else "writeout",
+                inputs=[
+                    tile_ty_trans,  # in buffer 0
+                    tile_ty_trans,  # in buffer 1
+                    elms_produced_ty,  # in buffer 0
+                    elms_produced_ty,  # in buffer 1
+                    tile_ty_out, # out buffer 0
+                    tile_ty_out, # out buffer 1
+                    T.index(),  # in acq_lock
+                    T.index(),  # in rel_lock
+                    T.index(),  # inelems acq_lock
+                    T.index(),  # inelems rel_lock
+                    T.index(),  # out acq_lock
+                    T.index(),  # out rel_lock
+                    elms_produced_ty,
+                    np.int32,#iters_outer
+                    np.int32,#iters_inner
+                ]
+            )
+
+            # Tile declarations
+            ShimTile00 = tile(0, 0)
+            ShimTile10 = tile(1, 0)
+            ShimTile20 = tile(2, 0)
+            MemTile01 = tile(0, 1)
+            MemTile11 = tile(1, 1)
+            ComputeTile02 = tile(0, 2)
+            ComputeTile12 = tile(1, 2)
+
+            # AIE-array data movement with object fifos
+            # Input
+            #tile_ty = np.ndarray[(host_elements,), np.dtype[np.int32]]
+
+            of_in_sh = object_fifo("in", ShimTile00, MemTile01, 2, tile_ty_in)
+            of_in_inner_sh = object_fifo("in_inner", ShimTile00, MemTile01, 2, tile_ty_in)
+
+            of_in1 = object_fifo("in1", MemTile01, ComputeTile02, 2, tile_ty_in)
+            of_in_inner = object_fifo("in1_inner", MemTile01, ComputeTile02, 2, tile_ty_in)
+            object_fifo_link(of_in_sh, of_in1)
+            object_fifo_link(of_in_inner_sh, of_in_inner)
+
+            trans = object_fifo("trans", ComputeTile02, ComputeTile12, 2, tile_ty_trans)
+
+            one_element = np.ndarray[(1,), np.dtype[np.int32]]
+            of_numer_els = object_fifo("of_numer_els", ComputeTile02, ComputeTile12, 2, one_element)
+
+
+            tile_ty_out_mem = np.ndarray[(tile_ty_size_out,), np.dtype[np.int32]]
+            # Output
+            of_out1 = object_fifo("out", ComputeTile12, MemTile11, 2, tile_ty_out)
+            of_out = object_fifo("out1", MemTile11, ShimTile10, 2, tile_ty_out_mem)
+            object_fifo_link(of_out1, of_out)
+
+            data_ty_done = np.ndarray[(16,), np.dtype[np.int32]]
+            of_done = object_fifo("outdone", ComputeTile12, ShimTile10, 2, data_ty_done)
+
+
+
+
+            # Set up compute tiles
+            # Compute tile
+            hist = aie.buffer(
+                tile=ComputeTile02,
+                datatype=hist_ty,
+                name=f"hist",
+                initial_value=np.zeros(domain, dtype=np.int32)
+            )
+
+            def build_tile(n_b):
+                elem_inner = of_in_inner.acquire(ObjectFifoPort.Consume, 1)
+                call(hist_build, [elem_inner, n_b, hist, domain])
+                of_in_inner.release(ObjectFifoPort.Consume, 1)
+
+            def probe_tile(n_a):
+                elem_in = of_in1.acquire(ObjectFifoPort.Consume, 1)
+                out = trans.acquire(ObjectFifoPort.Produce, 1)
+                numer_el = of_numer_els.acquire(ObjectFifoPort.Produce, 1)
+
+                call(hist_probe, [elem_in, n_a, hist, domain, out, numer_el])
+
+                of_numer_els.release(ObjectFifoPort.Produce, 1)
+                trans.release(ObjectFifoPort.Produce, 1)
+                of_in1.release(ObjectFifoPort.Consume, 1)
+
+            @core(ComputeTile02, "odd_even.o",dynamic_objfifo_lowering=False)
+            def core_body_02():
+
+                for _ in range_(0xFFFFFFFF):
+                    #build: one pass over B
+                    call(hist_clear, [hist, domain])
+                    for _ in range_(iters_inner):
+                        build_tile(tile_ty_size_in)
+                    if tail_b > 0:
+                        build_tile(tail_b)
+
+                    #probe: one pass over A
+                    for _ in range_(iters_outer):
+                        probe_tile(tile_ty_size_in)
+                    if tail_a > 0:
+                        probe_tile(tail_a)
+
+            ty_one_int = np.ndarray[(1,), np.dtype[np.int32]]
+
+            elemt_coutn = aie.buffer(
+                tile=ComputeTile12,
+                datatype=ty_one_int,
+                name=f"join_cnt",
+                initial_value=np.array(0, dtype=np.int32)
+            )
+
+            @core(ComputeTile12, "odd_even.o", dynamic_objfifo_lowering=False)
+            def core_body_12():
+                elemt_coutn[0] = 0
+                for _ in range_(0xFFFFFFFF):
+                    in_buf0 = trans.get_buffer(0)
+                    in_buf1 = trans.get_buffer(1)
+                    in_acq, in_rel = trans.get_lock(ObjectFifoPort.Consume)
+
+                    numer_els_buf0 = of_numer_els.get_buffer(0)
+                    numer_els_buf1 = of_numer_els.get_buffer(1)
+                    numer_els_acq, numer_els_rel = of_numer_els.get_lock(ObjectFifoPort.Consume)
+
+
+                    out_buf0 = of_out1.get_buffer(0)
+                    out_buf1 = of_out1.get_buffer(1)
+                    out_acq, out_rel = of_out1.get_lock(ObjectFifoPort.Produce)
+
+                    writeout(in_buf0,in_buf1,
+                             numer_els_buf0,numer_els_buf1,
+                             out_buf0,out_buf1,
+                             in_acq,in_rel,
+                             numer_els_acq, numer_els_rel,
+                             out_acq,out_rel,
+                             elemt_coutn,
+                             tiles_a,
+                             1
+                             )
+
+                    # elemt_coutn[0] = 0
+                    # for _ in range_(iters_outer*iters_inner):
+                    #     el = trans.acquire(ObjectFifoPort.Consume, 1)
+                    #     numer_el = of_numer_els.acquire(ObjectFifoPort.Consume, 1)
+                    #     out = of_out1.acquire(ObjectFifoPort.Produce, 1)
+                    #     call(passThroughLine,
+                    #          [el, out, 64*64])
+                    #     elemt_coutn[0] = numer_el[0] +elemt_coutn[0]
+                    #     of_out1.release(ObjectFifoPort.Produce, 1)
+                    #     of_numer_els.release(ObjectFifoPort.Consume, 1)
+                    #     trans.release(ObjectFifoPort.Consume, 1)
+
+                    elem_done = of_done.acquire(ObjectFifoPort.Produce, 1)
+                    for i in range_(16):
+                        elem_done[i] = 77
+                    elem_done[0] =  elemt_coutn[0]
+                    of_done.release(ObjectFifoPort.Produce, 1)
+
+
+
+
+
+
+
+
+            tiles_to_trace = [ComputeTile12,ComputeTile02 ]
+            if trace_size > 0:
+                trace_utils.configure_packet_tracing_flow(tiles_to_trace, ShimTile20)
+                #todo use other shimtile to trace?
+
+
+
+
+            @runtime_sequence(data_ty_a, data_ty_b,data_ty_out,data_ty_done)
+            def sequence(inTensor,innerinTensor,outOddTensor,doneTensor):
+
+                if trace_size > 0:
+                    trace_utils.configure_packet_tracing_aie2( #todo is this method correct form every npu?
+                        tiles_to_trace=tiles_to_trace,
+                        shim=ShimTile20,
+                        ddr_id=4,# 4 -> group_id(7)
+                        trace_size=trace_size,
+                    )
+
+
+
+
+                in_task = shim_dma_single_bd_task(of_in_sh, inTensor, offset= 0 ,sizes=[1, 1, 1, tranfer_size_elemnts_a],issue_token=False)
+                out_task = shim_dma_single_bd_task(
+                    of_out, outOddTensor, offset=0, sizes=[1, 1, 1, tranfer_size_elemnts_out]
+                )
+
+                done_task = shim_dma_single_bd_task(
+                    of_done, doneTensor, offset=0, sizes=[1, 1, 1, 16], issue_token=True, burst_length=64
+                )
+
+                dma_start_task(in_task, out_task, done_task)
+
+                #B is only needed once, for the histogram
+                inner_in_task1 = shim_dma_single_bd_task(of_in_inner_sh, innerinTensor, offset=0,
+                                                  sizes=[1, 1, 1, tranfer_size_elemnts_b], issue_token=True)
+
+                dma_start_task(inner_in_task1)
+                dma_await_task(inner_in_task1)
+
+
+
+                dma_await_task(done_task)
+                dma_free_task(in_task)
+                dma_free_task(out_task)
+
+                if trace_size > 0:
+                    trace_utils.gen_trace_done_aie2(ShimTile20)
+
+
+
+
+
+    res = ctx.module.operation.verify()
+    if res == True:
+        print(ctx.module)
+    else:
+        print(res)
+
+
+external_mem_to_core()
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <type_traits>
+#include <algorithm>
+#ifndef AIE_HOST_EMULATION
+#include <aie_api/aie.hpp>
+#include <aie_api/utils.hpp>
+#endif
+#include "aie_kernel_utils.h"
+#include "aie_objectfifo.h"
+
+
+
+
+
+extern "C" {
+
+
+void writeout(
+            int32_t * restrict in_buf0, int32_t * restrict in_buf1,
+            int32_t * restrict in_of_numer0, int32_t * in_of_numer1,
+            int32_t * restrict out_buf0,int32_t * restrict out_buf1,
+            int64_t in_acq_lock,int64_t in_rel_lock,
+            int64_t in_of_numer_acq_lock,int64_t in_of_numer_rel_lock,
+            int64_t out_acq_lock, int64_t out_rel_lock,
+            int32_t * restrict elems_produced,
+            const int32_t iters_outer,
+            const int32_t iters_inner
+            ) {
+            *elems_produced =0;
+
+            objectfifo_t of_in = {(int32_t)in_acq_lock, (int32_t)in_rel_lock, -1, 1, 2,
+                                {in_buf0, in_buf1}};
+            objectfifo_t of_in_of_numer = {(int32_t)in_of_numer_acq_lock, (int32_t)in_of_numer_rel_lock, -1, 1, 2,
+                                {in_of_numer0, in_of_numer1}};
+
+            objectfifo_t of_out = {(int32_t)out_acq_lock, (int32_t)out_rel_lock, -1, 1, 2,
+                                 {out_buf0, out_buf1}};
+
+
+            objectfifo_acquire(&of_out);
+            int32_t *out = (int32_t *)objectfifo_get_buffer(&of_out, 0);
+            int freeOutBuf = 4096;
+            int outCount = 0;
+            int count_out_ac = 1;
+
+            //262144
+            //for (int i = 0; i < 65536; i++) {
+            //todo why are two loops not possible
+            for (int64_t i = 0; i < ((int64_t)iters_outer)*(int64_t)iters_inner; i++) {
+
+            //for (int i = 0; i < 512; i++) {
+            //for (int z = 0; z < 512; z++) {
+                objectfifo_acquire(&of_in);
+                int32_t *input = (int32_t *)objectfifo_get_buffer(&of_in, i);
+
+                objectfifo_acquire(&of_in_of_numer);
+                int32_t *numer_el = (int32_t *)objectfifo_get_buffer(&of_in_of_numer, i);
+                //event0();
+                *elems_produced += *numer_el;
+
+                auto to_copy = std::min(*numer_el,freeOutBuf);
+
+
+
+              for (int j = 0; j < to_copy; j += 1) // Nx samples per loop
+              {
+                out[j+outCount] = input[j];
+              }
+              freeOutBuf = freeOutBuf - to_copy;
+              outCount = outCount + to_copy;
+
+              if(freeOutBuf == 0){
+
+                objectfifo_release(&of_out);
+                objectfifo_acquire(&of_out);
+                out = (int32_t *)objectfifo_get_buffer(&of_out, count_out_ac);
+                count_out_ac ++;
+
+                freeOutBuf = 4096;
+                outCount =0;
+                for (int j = 0; j < ((*numer_el) - to_copy); j += 1) // Nx samples per loop
+                {
+                out[j] = input[j+to_copy];
+                }
+                freeOutBuf = freeOutBuf -((*numer_el) - to_copy);
+                outCount = outCount + ((*numer_el) - to_copy);
+              }
+                //event1();
+
+                objectfifo_release(&of_in_of_numer);
+                objectfifo_release(&of_in);
+
+            }//}
+            for (int j = outCount; j < 4096; j += 1){
+            out[j] = -1;
+            }
+            objectfifo_release(&of_out);
+
+         }
+
+
+
+
+
+//writeout for the (key, count) pairs of hist_probe: every pair becomes count
+//copies of the key in the output, so the result looks like the one of the
+//nested loop join. A pair may span several out buffers.
+void writeout_expand(
+            int32_t * restrict in_buf0, int32_t * restrict in_buf1,
+            int32_t * restrict in_of_numer0, int32_t * in_of_numer1,
+            int32_t * restrict out_buf0,int32_t * restrict out_buf1,
+            int64_t in_acq_lock,int64_t in_rel_lock,
+            int64_t in_of_numer_acq_lock,int64_t in_of_numer_rel_lock,
+            int64_t out_acq_lock, int64_t out_rel_lock,
+            int32_t * restrict elems_produced,
+            const int32_t iters_outer,
+            const int32_t iters_inner
+            ) {
+            *elems_produced =0;
+
+            objectfifo_t of_in = {(int32_t)in_acq_lock, (int32_t)in_rel_lock, -1, 1, 2,
+                                {in_buf0, in_buf1}};
+            objectfifo_t of_in_of_numer = {(int32_t)in_of_numer_acq_lock, (int32_t)in_of_numer_rel_lock, -1, 1, 2,
+                                {in_of_numer0, in_of_numer1}};
+
+            objectfifo_t of_out = {(int32_t)out_acq_lock, (int32_t)out_rel_lock, -1, 1, 2,
+                                 {out_buf0, out_buf1}};
+
+            objectfifo_acquire(&of_out);
+            int32_t *out = (int32_t *)objectfifo_get_buffer(&of_out, 0);
+            int outCount = 0;
+            int count_out_ac = 1;
+
+            for (int64_t i = 0; i < ((int64_t)iters_outer)*(int64_t)iters_inner; i++) {
+                objectfifo_acquire(&of_in);
+                int32_t *input = (int32_t *)objectfifo_get_buffer(&of_in, i);
+
+                objectfifo_acquire(&of_in_of_numer);
+                int32_t *numer_el = (int32_t *)objectfifo_get_buffer(&of_in_of_numer, i);
+
+                for (int p = 0; p < *numer_el; p += 2) {
+                    int32_t key = input[p];
+                    int32_t count = input[p + 1];
+                    while (count > 0) {
+                        int n = std::min(count, 4096 - outCount);
+                        for (int j = 0; j < n; j++)
+                            out[outCount + j] = key;
+                        outCount += n;
+                        count -= n;
+                        *elems_produced += n;
+                        if (outCount == 4096) {
+                            objectfifo_release(&of_out);
+                            objectfifo_acquire(&of_out);
+                            out = (int32_t *)objectfifo_get_buffer(&of_out, count_out_ac);
+                            count_out_ac++;
+                            outCount = 0;
+                        }
+                    }
+                }
+
+                objectfifo_release(&of_in_of_numer);
+                objectfifo_release(&of_in);
+            }
+            for (int j = outCount; j < 4096; j += 1){
+            out[j] = -1;
+            }
+            objectfifo_release(&of_out);
+
+         }
+
+//histogram join for small key domains: core02 counts the keys of B in a
+//histogram in its local memory (one pass over B), then probes every key of
+//A against it (one pass over A). Keys have to be in [0, domain), others
+//are not counted and never match. The probe writes one (key, count) pair
+//per key of A that matches, at most 2 * 64 words per tile. There is no
+//vector gather / scatter on the core, the loops are scalar but pipelined.
+void hist_clear(int32_t * restrict hist, const int32_t domain) {
+   for (int k = 0; k < domain; k++)
+      hist[k] = 0;
+}
+
+void hist_build(int32_t * restrict input1, const int32_t n_b, int32_t * restrict hist, const int32_t domain) {
+   for (int j = 0; j < n_b; j++) {
+      int32_t key = input1[j];
+      if ((uint32_t)key < (uint32_t)domain)
+         hist[key]++;
+   }
+}
+
+void hist_probe(int32_t * restrict input, const int32_t n_a, int32_t * restrict hist, const int32_t domain, int32_t * restrict value, int32_t * restrict elems_produced) {
+   int k = 0;
+  AIE_PREPARE_FOR_PIPELINING
+   for (int i = 0; i < n_a; i++) {
+      int32_t key = input[i];
+      int32_t count = (uint32_t)key < (uint32_t)domain ? hist[key] : 0;
+      value[k] = key;
+      value[k + 1] = count;
+      k += count != 0 ? 2 : 0;
+   }
+   *elems_produced = k;
+}
+
+} // extern "C"
@@ -0,0 +1,112 @@
+//===- host_emu.cpp ---------------------------------------------*- C++ -*-===//
+//
+// Runs the join design of this directory on x86 threads (see host_emu.h),
+// checks the result against the host hash join and prints throughput and
+// per lock stall statistics. Exits with 1 on a mismatch or a deadlock.
+//
+// ./host_emu.exe [host_elements] [dist] [iters] [lock_timeout_ms]
+//
+// iters 0 only prints the chunk / group schedule of aie2.py, for sizes
+// whose cross product is too large to emulate.
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "hash_join.h"
+#include "join_verify.h"
+#include "host_emu.h"
+
+using DATATYPE = std::int32_t;
+
+int main(int argc, const char *argv[]) {
+  int64_t host_elements = argc > 1 ? std::atoll(argv[1]) : 1024;
+  int32_t upperdist = argc > 2 ? std::atoi(argv[2]) : 300;
+  int n_iterations = argc > 3 ? std::atoi(argv[3]) : 1;
+  int timeout_ms = argc > 4 ? std::atoi(argv[4]) : 10000;
+
+  if (host_elements % HOST_EMU_TILE_IN != 0) {
+    std::cout << "host_elements must be a multiple of " << HOST_EMU_TILE_IN
+              << "\n";
+    return 1;
+  }
+  std::cout << "host_elements: " << host_elements << "\n";
+
+  HostEmuSchedule sched = host_emu_schedule(host_elements);
+  std::cout << "schedule: " << sched.n_chunks << " chunks of "
+            << sched.chunk_elements << ", " << sched.n_groups << " groups of "
+            << sched.group_tiles << " tiles\n";
+  if (!sched.valid) {
+    std::cout << "host_elements does not split into whole chunks/groups\n";
+    return 1;
+  }
+  if (n_iterations == 0)
+    return 0;
+
+  host_aie::LockTable::get().timeout = std::chrono::milliseconds(timeout_ms);
+
+  //the drain stops writing at the end of out, only the join count matters
+  int64_t OUT_SIZE = host_elements * host_elements + HOST_EMU_TILE_OUT;
+  std::vector<DATATYPE> bufInA(host_elements), bufInB(host_elements);
+  std::vector<DATATYPE> bufOut(OUT_SIZE);
+  uint32_t bufDone[16];
+
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<DATATYPE> dist(1, upperdist);
+
+  int errors = 0;
+  for (int iter = 0; iter < n_iterations; iter++) {
+    for (auto &x : bufInA)
+      x = dist(rng);
+    for (auto &x : bufInB)
+      x = dist(rng);
+
+    HostEmuStats stats;
+    bool ok = run_join_design_on_host(bufInA.data(), bufInB.data(),
+                                      host_elements, bufOut.data(), OUT_SIZE,
+                                      bufDone, &stats);
+    if (!ok) {
+      std::cout << (stats.deadlock ? "deadlock: " : "error: ") << stats.error
+                << "\n";
+      errors++;
+    }
+
+    double comparisons = (double)host_elements * host_elements;
+    std::cout << "emulated time: " << stats.seconds * 1e6 << "us, "
+              << comparisons / stats.seconds / 1e6 << " Mcmp/s, "
+              << bufDone[0] / stats.seconds / 1e6 << " Mout/s, "
+              << stats.out_buffers << " out buffers\n";
+    for (auto &l : stats.locks)
+      if (l.blocked)
+        std::cout << "  " << l.name << ": " << l.blocked << "/" << l.acquires
+                  << " acquires blocked, " << l.wait_ms << "ms waiting\n";
+
+    if (!ok)
+      continue;
+
+    join_utils::JoinResult<DATATYPE> ref = join_utils::radix_hash_join(
+        bufInA.data(), host_elements, bufInB.data(), host_elements, false);
+    join_utils::VerifyResult<DATATYPE> check = join_utils::verify_join_output(
+        bufOut.data(), std::min<int64_t>(bufDone[0], OUT_SIZE), ref.histogram);
+    if (check.equal) {
+      std::cout << "equal\n";
+    } else {
+      std::cout << "not equal, first differing key: " << check.key
+                << " expected: " << check.expected << " got: " << check.got
+                << "\n";
+      errors++;
+    }
+  }
+
+  if (!errors) {
+    std::cout << std::endl << "PASS!" << std::endl << std::endl;
+    return 0;
+  }
+  std::cout << std::endl << errors << " mismatches." << std::endl << std::endl;
+  std::cout << std::endl << "fail." << std::endl << std::endl;
+  return 1;
+}
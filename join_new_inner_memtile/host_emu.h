@@ -0,0 +1,261 @@
+//===- host_emu.h -----------------------------------------------*- C++ -*-===//
+//
+// Runs the aie2.py design of this directory on the host: every core and
+// every shim DMA channel becomes a std::thread, every object fifo a
+// host_aie::ObjectFifo. core_body_02 calls the (scalar model of) odd_even,
+// core_body_12 calls the unmodified writeout() from odd_even.cc, which
+// drives its locks through the host aie_objectfifo.h.
+//
+// The MemTile hops (in -> in1, in_inner -> in1_inner, out -> out1) are
+// folded into one fifo each, with the depth of the compute tile side. The
+// inner shim thread replays each chunk of B group_tiles times, which is what
+// the repeat count of in1_inner does on the MemTile.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef HOST_EMU_H
+#define HOST_EMU_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "host_locks.h"
+
+extern "C" {
+void odd_even(int32_t *input, int32_t *input1, int32_t *value, const int32_t N,
+              int32_t *elems_produced);
+void writeout(int32_t *in_buf0, int32_t *in_buf1, int32_t *in_of_numer0,
+              int32_t *in_of_numer1, int32_t *out_buf0, int32_t *out_buf1,
+              int64_t in_acq_lock, int64_t in_rel_lock,
+              int64_t in_of_numer_acq_lock, int64_t in_of_numer_rel_lock,
+              int64_t out_acq_lock, int64_t out_rel_lock,
+              int32_t *elems_produced, const int32_t iters_outer,
+              const int32_t iters_inner);
+}
+
+struct HostEmuLockStats {
+  std::string name;
+  uint64_t acquires;
+  uint64_t blocked;
+  double wait_ms;
+};
+
+struct HostEmuStats {
+  double seconds = 0;
+  uint64_t out_buffers = 0;
+  bool deadlock = false;
+  std::string error;
+  std::vector<HostEmuLockStats> locks;
+};
+
+// Same constants as aie2.py
+constexpr int32_t HOST_EMU_TILE_IN = 64;
+constexpr int32_t HOST_EMU_TILE_OUT = HOST_EMU_TILE_IN * HOST_EMU_TILE_IN;
+constexpr int64_t HOST_EMU_MEMTILE_BYTES_INNER = 480 * 1024;
+constexpr int32_t HOST_EMU_MAX_REPEAT = 256;
+
+// B chunks that fit the MemTile, A groups of at most HOST_EMU_MAX_REPEAT
+// tiles, same rule as aie2.py: the smallest counts that split the tiles
+// evenly. valid is false if host_elements is not a multiple of the tile.
+struct HostEmuSchedule {
+  int64_t n_chunks, chunk_elements;
+  int64_t n_groups, group_tiles;
+  bool valid;
+};
+
+// smallest divisor of tiles that is at least min_parts
+inline int64_t host_emu_even_split(int64_t tiles, int64_t min_parts) {
+  int64_t parts = std::max<int64_t>(min_parts, 1);
+  while (parts < tiles && tiles % parts != 0)
+    parts++;
+  return parts;
+}
+
+inline HostEmuSchedule host_emu_schedule(int64_t host_elements) {
+  HostEmuSchedule s;
+  int64_t tiles = host_elements / HOST_EMU_TILE_IN;
+  s.n_chunks = host_emu_even_split(
+      tiles, (host_elements * 4 + HOST_EMU_MEMTILE_BYTES_INNER - 1) /
+                 HOST_EMU_MEMTILE_BYTES_INNER);
+  s.chunk_elements = host_elements / s.n_chunks;
+  s.n_groups = host_emu_even_split(
+      tiles, (tiles + HOST_EMU_MAX_REPEAT - 1) / HOST_EMU_MAX_REPEAT);
+  s.group_tiles = tiles / s.n_groups;
+  s.valid = tiles > 0 && host_elements % HOST_EMU_TILE_IN == 0 &&
+            tiles % s.n_chunks == 0 && tiles % s.n_groups == 0;
+  return s;
+}
+
+// Joins a[0 .. host_elements) with b[0 .. host_elements) through the emulated
+// design. out receives the drained out fifo buffers (at most out_size
+// elements), done the 16 words of the outdone fifo. Returns false on a
+// deadlock (lock acquire timeout) or any other error.
+inline bool run_join_design_on_host(const int32_t *a, const int32_t *b,
+                                    int64_t host_elements, int32_t *out,
+                                    int64_t out_size, uint32_t *done,
+                                    HostEmuStats *stats) {
+  using host_aie::ObjectFifo;
+  using Port = ObjectFifo<int32_t>::Port;
+
+  const HostEmuSchedule sched = host_emu_schedule(host_elements);
+  if (!sched.valid) {
+    if (stats)
+      stats->error = "host_elements is not a multiple of the tile size";
+    return false;
+  }
+  const int32_t iters_outer =
+      (int32_t)(sched.n_groups * sched.n_chunks * sched.group_tiles);
+  const int32_t iters_inner = (int32_t)(sched.chunk_elements / HOST_EMU_TILE_IN);
+
+  host_aie::LockTable &table = host_aie::LockTable::get();
+  table.clear();
+
+  ObjectFifo<int32_t> of_in1("in1", 2, HOST_EMU_TILE_IN);
+  ObjectFifo<int32_t> of_in_inner("in1_inner", 2, HOST_EMU_TILE_IN);
+  ObjectFifo<int32_t> trans("trans", 2, HOST_EMU_TILE_OUT);
+  ObjectFifo<int32_t> of_numer_els("of_numer_els", 2, 1);
+  ObjectFifo<int32_t> of_out1("out", 2, HOST_EMU_TILE_OUT);
+  ObjectFifo<int32_t> of_done("outdone", 2, 16);
+
+  std::mutex err_m;
+  std::string error;
+  bool deadlock = false;
+  auto guarded = [&](auto body) {
+    return [&, body]() {
+      try {
+        body();
+      } catch (const host_aie::lock_timeout &e) {
+        {
+          std::lock_guard<std::mutex> lk(err_m);
+          if (error.empty())
+            error = e.what() + std::string(" (") + table.name(e.lock_id) + ")";
+          deadlock = true;
+        }
+        table.shutdown();
+      } catch (const host_aie::lock_shutdown &) {
+        // torn down because another thread failed
+      } catch (const std::exception &e) {
+        {
+          std::lock_guard<std::mutex> lk(err_m);
+          if (error.empty())
+            error = e.what();
+        }
+        table.shutdown();
+      }
+    };
+  };
+
+  int32_t join_cnt = 0;
+  uint64_t out_buffers = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+
+  // shim DMA tasks of the runtime sequence
+  std::thread shim_in(guarded([&]() {
+    for (int64_t g = 0; g < sched.n_groups; g++)
+      for (int64_t c = 0; c < sched.n_chunks; c++)
+        for (int64_t i = 0; i < sched.group_tiles; i++) {
+          int32_t *dst = of_in1.acquire(Port::Produce);
+          std::memcpy(dst, a + (g * sched.group_tiles + i) * HOST_EMU_TILE_IN,
+                      HOST_EMU_TILE_IN * sizeof(int32_t));
+          of_in1.release(Port::Produce);
+        }
+  }));
+  std::thread shim_in_inner(guarded([&]() {
+    for (int64_t g = 0; g < sched.n_groups; g++)
+      for (int64_t c = 0; c < sched.n_chunks; c++)
+        for (int64_t r = 0; r < sched.group_tiles; r++)
+          for (int32_t j = 0; j < iters_inner; j++) {
+            int32_t *dst = of_in_inner.acquire(Port::Produce);
+            std::memcpy(dst,
+                        b + c * sched.chunk_elements +
+                            (int64_t)j * HOST_EMU_TILE_IN,
+                        HOST_EMU_TILE_IN * sizeof(int32_t));
+            of_in_inner.release(Port::Produce);
+          }
+  }));
+  std::thread shim_out([&]() {
+    int64_t offset = 0;
+    while (int32_t *src = of_out1.acquire_until_shutdown(Port::Consume)) {
+      int64_t n = std::min<int64_t>(HOST_EMU_TILE_OUT, out_size - offset);
+      if (n > 0)
+        std::memcpy(out + offset, src, n * sizeof(int32_t));
+      offset += HOST_EMU_TILE_OUT;
+      out_buffers++;
+      of_out1.release(Port::Consume);
+    }
+  });
+
+  // core_body_02
+  std::thread core02(guarded([&]() {
+    for (int32_t i = 0; i < iters_outer; i++) {
+      int32_t *elem_in = of_in1.acquire(Port::Consume);
+      for (int32_t j = 0; j < iters_inner; j++) {
+        int32_t *elem_inner = of_in_inner.acquire(Port::Consume);
+        int32_t *elem_out = trans.acquire(Port::Produce);
+        int32_t *numer_el = of_numer_els.acquire(Port::Produce);
+        odd_even(elem_in, elem_inner, elem_out, HOST_EMU_TILE_IN, numer_el);
+        of_numer_els.release(Port::Produce);
+        trans.release(Port::Produce);
+        of_in_inner.release(Port::Consume);
+      }
+      of_in1.release(Port::Consume);
+    }
+  }));
+
+  // core_body_12
+  std::thread core12(guarded([&]() {
+    writeout(trans.get_buffer(0), trans.get_buffer(1),
+             of_numer_els.get_buffer(0), of_numer_els.get_buffer(1),
+             of_out1.get_buffer(0), of_out1.get_buffer(1),
+             trans.acq_lock(Port::Consume), trans.rel_lock(Port::Consume),
+             of_numer_els.acq_lock(Port::Consume),
+             of_numer_els.rel_lock(Port::Consume),
+             of_out1.acq_lock(Port::Produce), of_out1.rel_lock(Port::Produce),
+             &join_cnt, iters_outer, iters_inner);
+    int32_t *elem_done = of_done.acquire(Port::Produce);
+    for (int i = 0; i < 16; i++)
+      elem_done[i] = 77;
+    elem_done[0] = join_cnt;
+    of_done.release(Port::Produce);
+  }));
+
+  // dma_await_task(done_task)
+  std::thread shim_done(guarded([&]() {
+    int32_t *src = of_done.acquire(Port::Consume);
+    std::memcpy(done, src, 16 * sizeof(uint32_t));
+    of_done.release(Port::Consume);
+  }));
+
+  shim_in.join();
+  shim_in_inner.join();
+  core02.join();
+  core12.join();
+  shim_done.join();
+  // everything the writeout released is already counted on the out lock,
+  // the drain empties it before it sees the shutdown
+  table.shutdown();
+  shim_out.join();
+  auto stop = std::chrono::high_resolution_clock::now();
+
+  if (stats) {
+    stats->seconds = std::chrono::duration<double>(stop - start).count();
+    stats->out_buffers = out_buffers;
+    stats->deadlock = deadlock;
+    stats->error = error;
+    stats->locks.clear();
+    for (size_t i = 0; i < table.size(); i++) {
+      host_aie::Semaphore &s = table[(int32_t)i];
+      stats->locks.push_back({table.name((int32_t)i), s.acquires(),
+                              s.blocked(), s.wait_ns() / 1e6});
+    }
+  }
+  return error.empty();
+}
+
+#endif
@@ -0,0 +1,235 @@
+from pkgutil import extend_path
+
+import numpy as np
+import sys
+import aie.utils.trace as trace_utils
+
+from aie.dialects.aie import *
+from aie.dialects.aiex import *
+from aie.helpers.dialects.scf import _for as range_, if_, else_
+from aie.extras.context import mlir_mod_ctx
+from setuptools.archive_util import extraction_drivers
+
+#use stderr so the mlir output does not break
+#These are don't have to be errors
+def eprint(*args, **kwargs):
+    print(*args, file=sys.stderr, **kwargs)
+
+if len(sys.argv) > 1:
+    if sys.argv[1] == "npu":
+        dev = AIEDevice.npu1
+    elif sys.argv[1] == "npu2":
+        dev = AIEDevice.npu2
+    else:
+        raise ValueError("[ERROR] Device name {} is unknown".format(sys.argv[1]))
+
+trace_size = 0
+if len(sys.argv) > 2:
+    if sys.argv[2].isdigit():
+        trace_size = int(sys.argv[2])
+        eprint("[INFO] trace_size: {}".format(trace_size))
+    else:
+        eprint("[Info] sys.argv[2] (trace_size):{} is not a positive number falling back to trace_size = 0".format(sys.argv[2]))
+
+host_elements = 1024
+if len(sys.argv) > 3:
+    if sys.argv[3].isdigit():
+        host_elements = int(sys.argv[3])
+        eprint("[INFO] host_elements: {}".format(host_elements))
+    else:
+        eprint("[Info] sys.argv[3] (host_elements):{} is not a positive number falling back to host_elements = 1024".format(sys.argv[3]))
+
+#compute tiles per column (rows 2 ..) and number of columns, each column
+#gets its own shim tile, MemTile, slice of A and output region
+cores_per_col = 4
+if len(sys.argv) > 4:
+    if sys.argv[4].isdigit():
+        cores_per_col = int(sys.argv[4])
+        eprint("[INFO] cores_per_col: {}".format(cores_per_col))
+    else:
+        eprint("[Info] sys.argv[4] (cores_per_col):{} is not a positive number falling back to cores_per_col = 4".format(sys.argv[4]))
+
+n_cols = 1
+if len(sys.argv) > 5:
+    if sys.argv[5].isdigit():
+        n_cols = int(sys.argv[5])
+        eprint("[INFO] n_cols: {}".format(n_cols))
+    else:
+        eprint("[Info] sys.argv[5] (n_cols):{} is not a positive number falling back to n_cols = 1".format(sys.argv[5]))
+
+
+
+def external_mem_to_core():
+    with mlir_mod_ctx() as ctx:
+
+        @device(dev)
+        def device_body():
+
+            #npu1 has 4 columns, npu2 8, both have 4 compute rows
+            max_cols = 8 if dev == AIEDevice.npu2 else 4
+            max_cores_per_col = 4
+            if cores_per_col < 1 or cores_per_col > max_cores_per_col:
+                raise ValueError("[ERROR] cores_per_col {} not in 1..{}".format(cores_per_col, max_cores_per_col))
+            if n_cols < 1 or n_cols > max_cols:
+                raise ValueError("[ERROR] n_cols {} not in 1..{}".format(n_cols, max_cols))
+
+            n_cores = cores_per_col * n_cols
+
+            tile_ty_size_in = 64
+            tile_ty_size_out = tile_ty_size_in * tile_ty_size_in
+
+            if host_elements % (tile_ty_size_in * n_cores) != 0:
+                raise ValueError("[ERROR] host_elements {} is not a multiple of {}".format(host_elements, tile_ty_size_in * n_cores))
+
+            tranfer_size_elemnts_in = host_elements
+            tranfer_size_elemnts_out = (host_elements*host_elements)
+
+            #every column joins its slice of A with all of B
+            col_elemnts_in = host_elements // n_cols
+            col_elemnts_out = col_elemnts_in * host_elements
+
+            eprint("[INFO] n_cores: {} ({} columns x {} cores)".format(n_cores, n_cols, cores_per_col))
+            eprint("[INFO] tranfer_size_elemnts_in: {}".format(tranfer_size_elemnts_in))
+            eprint("[INFO] tranfer_size_elemnts_out: {}".format(tranfer_size_elemnts_out))
+
+            eprint("[INFO] tile_ty_size_in: {}".format(tile_ty_size_in))
+            eprint("[INFO] tile_ty_size_out: {}".format(tile_ty_size_out))
+
+            #todo fix for A B different sizes
+            iters_outer = host_elements // tile_ty_size_in // n_cores
+            #one relation needs to be pushed several times
+            transfers_inner = iters_outer
+
+            # todo fix for A B different sizes
+            iters_inner = host_elements // tile_ty_size_in
+
+            eprint("[INFO] iters_outer: {}".format(iters_outer))
+            eprint("[INFO] iters_inner: {}".format(iters_inner))
+
+            eprint("[INFO] transfers_inner: {}".format(transfers_inner))
+
+            #the MemTile of a column splits A and joins the outputs of its cores
+            mem_ty_in = np.ndarray[(tile_ty_size_in * cores_per_col,), np.dtype[np.int32]]
+            mem_ty_out = np.ndarray[(tile_ty_size_out * cores_per_col,), np.dtype[np.int32]]
+
+            tile_ty_in = np.ndarray[(tile_ty_size_in,), np.dtype[np.int32]]
+            tile_ty_out = np.ndarray[(tile_ty_size_out,), np.dtype[np.int32]]
+
+            data_ty_in = np.ndarray[(tranfer_size_elemnts_in,), np.dtype[np.int32]]
+            data_ty_out = np.ndarray[(tranfer_size_elemnts_out,), np.dtype[np.int32]]
+
+
+            # External, binary kernel definition
+            odd_even = external_func(
+                "odd_even",
+                inputs=[tile_ty_in, tile_ty_in,tile_ty_out, np.int32]
+            )
+
+            def core_body_for(compute_tile, of_in_core, of_in_inner, of_out_core):
+                @core(compute_tile, "odd_even.o")
+                def core_body():
+
+                    for _ in range_(0xFFFFFFFF):
+                        for _ in range_(iters_outer):
+                            elem_in = of_in_core.acquire(ObjectFifoPort.Consume, 1)
+
+                            for _ in range_(iters_inner):
+                                elem_inner = of_in_inner.acquire(ObjectFifoPort.Consume, 1)
+                                out = of_out_core.acquire(ObjectFifoPort.Produce, 1)
+
+                                call(odd_even, [elem_in, elem_inner, out, tile_ty_size_in])
+
+                                of_out_core.release(ObjectFifoPort.Produce, 1)
+                                of_in_inner.release(ObjectFifoPort.Consume, 1)
+
+                            of_in_core.release(ObjectFifoPort.Consume, 1)
+
+            shim_tiles = []
+            of_ins = []
+            of_in_inner_put_ins = []
+            of_outs = []
+            compute_tiles = []
+
+            for c in range(n_cols):
+                # Tile declarations
+                ShimTile = tile(c, 0)
+                MemTile = tile(c, 1)
+                ComputeTiles = [tile(c, 2 + r) for r in range(cores_per_col)]
+                shim_tiles.append(ShimTile)
+                compute_tiles += ComputeTiles
+
+                # AIE-array data movement with object fifos
+                # Input
+                of_in = object_fifo("in_c{}".format(c), ShimTile, MemTile, 2, mem_ty_in)
+                of_in_cores = [object_fifo("in_c{}_{}".format(c, r), MemTile, ComputeTiles[r], 2, tile_ty_in)
+                               for r in range(cores_per_col)]
+                object_fifo_link(of_in, of_in_cores, [], [r * tile_ty_size_in for r in range(cores_per_col)])
+
+                of_in_inner_put_in = object_fifo("in_inner_put_in_c{}".format(c), ShimTile, MemTile, 2, tile_ty_in)
+                of_in_inner = object_fifo("in_inner_c{}".format(c), MemTile, ComputeTiles, 2, tile_ty_in)
+                object_fifo_link(of_in_inner_put_in, of_in_inner)
+
+                # Output
+                of_out = object_fifo("out_c{}".format(c), MemTile, ShimTile, 2, mem_ty_out)
+                of_out_cores = [object_fifo("out_c{}_{}".format(c, r), ComputeTiles[r], MemTile, 2, tile_ty_out)
+                                for r in range(cores_per_col)]
+                object_fifo_link(of_out_cores, of_out, [r * tile_ty_size_out for r in range(cores_per_col)], [])
+
+                of_ins.append(of_in)
+                of_in_inner_put_ins.append(of_in_inner_put_in)
+                of_outs.append(of_out)
+
+                # Set up compute tiles
+                for r in range(cores_per_col):
+                    core_body_for(ComputeTiles[r], of_in_cores[r], of_in_inner, of_out_cores[r])
+
+
+            tiles_to_trace = [compute_tiles[0]]
+            if trace_size > 0:
+                trace_utils.configure_packet_tracing_flow(tiles_to_trace, shim_tiles[0])
+
+
+            @runtime_sequence(data_ty_in, data_ty_in,data_ty_out)
+            def sequence(inTensor,innerinTensor,outOddTensor,):
+
+                if trace_size > 0:
+                    trace_utils.configure_packet_tracing_aie2( #todo is this method correct form every npu?
+                        tiles_to_trace=tiles_to_trace,
+                        shim=shim_tiles[0],
+                        ddr_id=4,# 4 -> group_id(7)
+                        trace_size=trace_size,
+                    )
+
+                in_tasks = []
+                out_tasks = []
+                for c in range(n_cols):
+                    in_tasks.append(shim_dma_single_bd_task(of_ins[c], inTensor, offset=c * col_elemnts_in,
+                                                            sizes=[1, 1, 1, col_elemnts_in], issue_token=False))
+                    out_tasks.append(shim_dma_single_bd_task(of_outs[c], outOddTensor, offset=c * col_elemnts_out,
+                                                             sizes=[1, 1, 1, col_elemnts_out], issue_token=True))
+                dma_start_task(*in_tasks, *out_tasks)
+
+                #every column pulls its own copy of B through its own shim
+                for i in range(transfers_inner):
+                    inner_in_tasks = [shim_dma_single_bd_task(of_in_inner_put_ins[c], innerinTensor, offset=0,
+                                                              sizes=[1, 1, 1, tranfer_size_elemnts_in], issue_token=True)
+                                      for c in range(n_cols)]
+                    dma_start_task(*inner_in_tasks)
+                    dma_await_task(*inner_in_tasks)
+
+                dma_await_task(*out_tasks)
+                for t in in_tasks:
+                    dma_free_task(t)
+
+                if trace_size > 0:
+                    trace_utils.gen_trace_done_aie2(shim_tiles[0])
+
+
+    res = ctx.module.operation.verify()
+    if res == True:
+        print(ctx.module)
+    else:
+        print(res)
+
+
+external_mem_to_core()
@@ -0,0 +1,11 @@
+#measured iterations per point for the percentiles, ./collect.sh 1 for a quick pass
+iters=${1:-100}
+rm -f bench_xchesscc.csv bench_xchesscc.json
+#scaling curve over the whole array, the benchmark records carry the core count
+for cols in 1 2 4
+do
+    for cores in 1 2 4
+    do
+        make clean && make run_xchesscc benchIters=${iters} hostElements=16384 coresPerCol=${cores} nCols=${cols}
+    done
+done
@@ -0,0 +1,335 @@
+from pkgutil import extend_path
+
+import numpy as np
+import sys
+import aie.utils.trace as trace_utils
+
+from aie.dialects.aie import *
+from aie.dialects.aiex import *
+from aie.helpers.dialects.scf import _for as range_, if_, else_
+from aie.extras.context import mlir_mod_ctx
+from setuptools.archive_util import extraction_drivers
+
+#use stderr so the mlir output does not break
+#These are don't have to be errors
+def eprint(*args, **kwargs):
+    print(*args, file=sys.stderr, **kwargs)
+
+if len(sys.argv) > 1:
+    if sys.argv[1] == "npu":
+        dev = AIEDevice.npu1
+    elif sys.argv[1] == "npu2":
+        dev = AIEDevice.npu2
+    else:
+        raise ValueError("[ERROR] Device name {} is unknown".format(sys.argv[1]))
+
+trace_size = 0
+if len(sys.argv) > 2:
+    if sys.argv[2].isdigit():
+        trace_size = int(sys.argv[2])
+        eprint("[INFO] trace_size: {}".format(trace_size))
+    else:
+        eprint("[Info] sys.argv[2] (trace_size):{} is not a positive number falling back to trace_size = 0".format(sys.argv[2]))
+
+host_elements = 1024
+if len(sys.argv) > 3:
+    if sys.argv[3].isdigit():
+        host_elements = int(sys.argv[3])
+        eprint("[INFO] host_elements: {}".format(host_elements))
+    else:
+        eprint("[Info] sys.argv[3] (host_elements):{} is not a positive number falling back to host_elements = 1024".format(sys.argv[3]))
+
+#capacity of one partition slot, a multiple of the 64 element tile
+part_elements = 512
+if len(sys.argv) > 4:
+    if sys.argv[4].isdigit() and int(sys.argv[4]) % 64 == 0:
+        part_elements = int(sys.argv[4])
+        eprint("[INFO] part_elements: {}".format(part_elements))
+    else:
+        eprint("[Info] sys.argv[4] (part_elements):{} is not a multiple of 64 falling back to part_elements = 512".format(sys.argv[4]))
+
+#same rule as join_utils/npu_partition.h partition_layout():
+#the fewest partitions (power of two) such that the slots hold twice the relation
+n_parts = 1
+while n_parts * part_elements < 2 * host_elements:
+    n_parts *= 2
+
+
+
+def external_mem_to_core():
+    with mlir_mod_ctx() as ctx:
+
+        @device(dev)
+        def device_body():
+
+
+
+
+
+            #the host radix partitions A and B into n_parts padded slots,
+            #slot p of A is only joined with slot p of B
+            tranfer_size_elemnts_in = n_parts * part_elements
+            #one GB
+            tranfer_size_elemnts_out = (268435456)
+
+
+            eprint("[INFO] tranfer_size_elemnts_in: {}".format(tranfer_size_elemnts_in))
+            eprint("[INFO] tranfer_size_elemnts_out: {}".format(tranfer_size_elemnts_out))
+
+
+            #eprint("[INFO] transfer size in KB: {}".format(tranfer_size_elemnts_in*4/1024))
+
+
+            #elements = 4096
+
+            tile_ty_size_in = 64
+            tile_ty_size_out = tile_ty_size_in * tile_ty_size_in
+
+            eprint("[INFO] tile_ty_size_in: {}".format(tile_ty_size_in))
+            eprint("[INFO] tile_ty_size_out: {}".format(tile_ty_size_out))
+
+            tiles_per_part = part_elements // tile_ty_size_in
+
+            #every outer tile of a partition meets every inner tile of the same partition
+            iters_outer = n_parts * tiles_per_part
+            iters_inner = tiles_per_part
+            #each B slot is pushed once per outer tile of its partition
+            transfers_inner = tiles_per_part
+
+            eprint("[INFO] n_parts: {}".format(n_parts))
+            eprint("[INFO] iters_outer: {}".format(iters_outer))
+            eprint("[INFO] iters_inner: {}".format(iters_inner))
+
+            eprint("[INFO] transfers_inner: {}".format(transfers_inner))
+
+
+            tile_ty_in = np.ndarray[(tile_ty_size_in,), np.dtype[np.int32]]
+            tile_ty_out = np.ndarray[(tile_ty_size_out,), np.dtype[np.int32]]
+
+            #buffer_ty = np.ndarray[(elements,), np.dtype[np.int32]]
+
+            data_ty_in = np.ndarray[(tranfer_size_elemnts_in,), np.dtype[np.int32]]
+            data_ty_out = np.ndarray[(tranfer_size_elemnts_out,), np.dtype[np.int32]]
+
+            elms_produced_ty = np.ndarray[(1,), np.dtype[np.int32]]
+
+            # External, binary kernel definition
+            odd_even = external_func(
+                "odd_even",
+                inputs=[tile_ty_in, tile_ty_in,tile_ty_out, np.int32,elms_produced_ty]
+            )
+
+            passThroughLine = external_func(
+                "passThroughLine",
+                inputs=[tile_ty_out, tile_ty_out, np.int32]
+            )
+
+            writeout = external_func(
+                "writeout",
+                inputs=[
+                    tile_ty_out,  # in buffer 0
+                    tile_ty_out,  # in buffer 1
+                    elms_produced_ty,  # in buffer 0
+                    elms_produced_ty,  # in buffer 1
+                    tile_ty_out, # out buffer 0
+                    tile_ty_out, # out buffer 1
+                    T.index(),  # in acq_lock
+                    T.index(),  # in rel_lock
+                    T.index(),  # inelems acq_lock
+                    T.index(),  # inelems rel_lock
+                    T.index(),  # out acq_lock
+                    T.index(),  # out rel_lock
+                    elms_produced_ty,
+                    np.int32,#iters_outer
+                    np.int32,#iters_inner
+                ]
+            )
+
+            # Tile declarations
+            ShimTile00 = tile(0, 0)
+            ShimTile10 = tile(1, 0)
+            ShimTile20 = tile(2, 0)
+            MemTile01 = tile(0, 1)
+            MemTile11 = tile(1, 1)
+            ComputeTile02 = tile(0, 2)
+            ComputeTile12 = tile(1, 2)
+
+            # AIE-array data movement with object fifos
+            # Input
+            #tile_ty = np.ndarray[(host_elements,), np.dtype[np.int32]]
+
+            of_in_sh = object_fifo("in", ShimTile00, MemTile01, 2, tile_ty_in)
+            of_in_inner_sh = object_fifo("in_inner", ShimTile00, MemTile01, 2, tile_ty_in)
+
+            of_in1 = object_fifo("in1", MemTile01, ComputeTile02, 2, tile_ty_in)
+            of_in_inner = object_fifo("in1_inner", MemTile01, ComputeTile02, 2, tile_ty_in)
+            object_fifo_link(of_in_sh, of_in1)
+            object_fifo_link(of_in_inner_sh, of_in_inner)
+
+            trans = object_fifo("trans", ComputeTile02, ComputeTile12, 2, tile_ty_out)
+
+            one_element = np.ndarray[(1,), np.dtype[np.int32]]
+            of_numer_els = object_fifo("of_numer_els", ComputeTile02, ComputeTile12, 2, one_element)
+
+
+            tile_ty_out_mem = np.ndarray[(tile_ty_size_out,), np.dtype[np.int32]]
+            # Output
+            of_out1 = object_fifo("out", ComputeTile12, MemTile11, 2, tile_ty_out)
+            of_out = object_fifo("out1", MemTile11, ShimTile10, 2, tile_ty_out_mem)
+            object_fifo_link(of_out1, of_out)
+
+            data_ty_done = np.ndarray[(16,), np.dtype[np.int32]]
+            of_done = object_fifo("outdone", ComputeTile12, ShimTile10, 2, data_ty_done)
+
+
+
+
+            # Set up compute tiles
+            # Compute tile
+            @core(ComputeTile02, "odd_even.o",dynamic_objfifo_lowering=False)
+            def core_body_02():
+
+                for _ in range_(0xFFFFFFFF):
+                    #for _ in range_(iters):
+                    for _ in range_(iters_outer):
+                        elem_in = of_in1.acquire(ObjectFifoPort.Consume, 1)
+
+                        for _ in range_(iters_inner):
+                            elem_inner = of_in_inner.acquire(ObjectFifoPort.Consume, 1)
+                            out = trans.acquire(ObjectFifoPort.Produce, 1)
+                            numer_el = of_numer_els.acquire(ObjectFifoPort.Produce, 1)
+
+                            call(odd_even, [elem_in, elem_inner, out, tile_ty_size_in,numer_el])
+
+                            of_numer_els.release(ObjectFifoPort.Produce, 1)
+                            trans.release(ObjectFifoPort.Produce, 1)
+                            of_in_inner.release(ObjectFifoPort.Consume, 1)
+
+
+                        of_in1.release(ObjectFifoPort.Consume, 1)
+
+            ty_one_int = np.ndarray[(1,), np.dtype[np.int32]]
+
+            elemt_coutn = aie.buffer(
+                tile=ComputeTile12,
+                datatype=ty_one_int,
+                name=f"join_cnt",
+                initial_value=np.array(0, dtype=np.int32)
+            )
+
+            @core(ComputeTile12, "odd_even.o", dynamic_objfifo_lowering=False)
+            def core_body_12():
+                elemt_coutn[0] = 0
+                for _ in range_(0xFFFFFFFF):
+                    in_buf0 = trans.get_buffer(0)
+                    in_buf1 = trans.get_buffer(1)
+                    in_acq, in_rel = trans.get_lock(ObjectFifoPort.Consume)
+
+                    numer_els_buf0 = of_numer_els.get_buffer(0)
+                    numer_els_buf1 = of_numer_els.get_buffer(1)
+                    numer_els_acq, numer_els_rel = of_numer_els.get_lock(ObjectFifoPort.Consume)
+
+
+                    out_buf0 = of_out1.get_buffer(0)
+                    out_buf1 = of_out1.get_buffer(1)
+                    out_acq, out_rel = of_out1.get_lock(ObjectFifoPort.Produce)
+
+                    writeout(in_buf0,in_buf1,
+                             numer_els_buf0,numer_els_buf1,
+                             out_buf0,out_buf1,
+                             in_acq,in_rel,
+                             numer_els_acq, numer_els_rel,
+                             out_acq,out_rel,
+                             elemt_coutn,
+                             iters_outer,
+                             iters_inner
+                             )
+
+                    # elemt_coutn[0] = 0
+                    # for _ in range_(iters_outer*iters_inner):
+                    #     el = trans.acquire(ObjectFifoPort.Consume, 1)
+                    #     numer_el = of_numer_els.acquire(ObjectFifoPort.Consume, 1)
+                    #     out = of_out1.acquire(ObjectFifoPort.Produce, 1)
+                    #     call(passThroughLine,
+                    #          [el, out, 64*64])
+                    #     elemt_coutn[0] = numer_el[0] +elemt_coutn[0]
+                    #     of_out1.release(ObjectFifoPort.Produce, 1)
+                    #     of_numer_els.release(ObjectFifoPort.Consume, 1)
+                    #     trans.release(ObjectFifoPort.Consume, 1)
+
+                    elem_done = of_done.acquire(ObjectFifoPort.Produce, 1)
+                    for i in range_(16):
+                        elem_done[i] = 77
+                    elem_done[0] =  elemt_coutn[0]
+                    of_done.release(ObjectFifoPort.Produce, 1)
+
+
+
+
+
+
+
+
+            tiles_to_trace = [ComputeTile12,ComputeTile02 ]
+            if trace_size > 0:
+                trace_utils.configure_packet_tracing_flow(tiles_to_trace, ShimTile20)
+                #todo use other shimtile to trace?
+
+
+
+
+            @runtime_sequence(data_ty_in, data_ty_in,data_ty_out,data_ty_done)
+            def sequence(inTensor,innerinTensor,outOddTensor,doneTensor):
+
+                if trace_size > 0:
+                    trace_utils.configure_packet_tracing_aie2( #todo is this method correct form every npu?
+                        tiles_to_trace=tiles_to_trace,
+                        shim=ShimTile20,
+                        ddr_id=4,# 4 -> group_id(7)
+                        trace_size=trace_size,
+                    )
+
+
+
+
+                in_task = shim_dma_single_bd_task(of_in_sh, inTensor, offset= 0 ,sizes=[1, 1, 1, tranfer_size_elemnts_in],issue_token=False)
+                out_task = shim_dma_single_bd_task(
+                    of_out, outOddTensor, offset=0, sizes=[1, 1, 1, tranfer_size_elemnts_out]
+                )
+
+                done_task = shim_dma_single_bd_task(
+                    of_done, doneTensor, offset=0, sizes=[1, 1, 1, 16], issue_token=True, burst_length=64
+                )
+
+                dma_start_task(in_task, out_task, done_task)
+
+                for p in range(n_parts):
+                    #repeat dimension with stride 0 replays the slot transfers_inner times
+                    inner_in_task1 = shim_dma_single_bd_task(of_in_inner_sh, innerinTensor, offset=p * part_elements,
+                                                      sizes=[transfers_inner, 1, 1, part_elements],
+                                                      strides=[0, 0, 0, 1], issue_token=True)
+
+                    dma_start_task(inner_in_task1)
+                    dma_await_task(inner_in_task1)
+
+
+
+                dma_await_task(done_task)
+                dma_free_task(in_task)
+                dma_free_task(out_task)
+
+                if trace_size > 0:
+                    trace_utils.gen_trace_done_aie2(ShimTile20)
+
+
+
+
+
+    res = ctx.module.operation.verify()
+    if res == True:
+        print(ctx.module)
+    else:
+        print(res)
+
+
+external_mem_to_core()
\ No newline at end of file
@@ -0,0 +1,220 @@
+//===- host_emu.h -----------------------------------------------*- C++ -*-===//
+//
+// Runs the aie2.py design of this directory on the host: every core and
+// every shim DMA channel becomes a std::thread, every object fifo a
+// host_aie::ObjectFifo. core_body_02 calls the (scalar model of) odd_even,
+// core_body_12 calls the unmodified writeout() from odd_even.cc, which
+// drives its locks through the host aie_objectfifo.h.
+//
+// The MemTile hops (in -> in1, out -> out1) are folded into one fifo each,
+// with the depth of the compute tile side.
+//
+// a and b are the padded partition slots, n_parts slots of part_elements
+// each; the inner shim channel replays slot p of b once per outer tile of
+// slot p like the runtime sequence of aie2.py.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef HOST_EMU_H
+#define HOST_EMU_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "host_locks.h"
+
+extern "C" {
+void odd_even(int32_t *input, int32_t *input1, int32_t *value, const int32_t N,
+              int32_t *elems_produced);
+void writeout(int32_t *in_buf0, int32_t *in_buf1, int32_t *in_of_numer0,
+              int32_t *in_of_numer1, int32_t *out_buf0, int32_t *out_buf1,
+              int64_t in_acq_lock, int64_t in_rel_lock,
+              int64_t in_of_numer_acq_lock, int64_t in_of_numer_rel_lock,
+              int64_t out_acq_lock, int64_t out_rel_lock,
+              int32_t *elems_produced, const int32_t iters_outer,
+              const int32_t iters_inner);
+}
+
+struct HostEmuLockStats {
+  std::string name;
+  uint64_t acquires;
+  uint64_t blocked;
+  double wait_ms;
+};
+
+struct HostEmuStats {
+  double seconds = 0;
+  uint64_t out_buffers = 0;
+  bool deadlock = false;
+  std::string error;
+  std::vector<HostEmuLockStats> locks;
+};
+
+// Same constants as aie2.py
+constexpr int32_t HOST_EMU_TILE_IN = 64;
+constexpr int32_t HOST_EMU_TILE_OUT = HOST_EMU_TILE_IN * HOST_EMU_TILE_IN;
+
+// Joins slot p of a with slot p of b for every partition through the
+// emulated design. out receives the drained out fifo buffers (at most out_size
+// elements), done the 16 words of the outdone fifo. Returns false on a
+// deadlock (lock acquire timeout) or any other error.
+inline bool run_join_design_on_host(const int32_t *a, const int32_t *b,
+                                    int64_t n_parts, int64_t part_elements,
+                                    int32_t *out,
+                                    int64_t out_size, uint32_t *done,
+                                    HostEmuStats *stats) {
+  using host_aie::ObjectFifo;
+  using Port = ObjectFifo<int32_t>::Port;
+
+  const int32_t tiles_per_part = (int32_t)(part_elements / HOST_EMU_TILE_IN);
+  const int32_t iters_outer = (int32_t)n_parts * tiles_per_part;
+  const int32_t iters_inner = tiles_per_part;
+  const int32_t transfers_inner = tiles_per_part;
+
+  host_aie::LockTable &table = host_aie::LockTable::get();
+  table.clear();
+
+  ObjectFifo<int32_t> of_in1("in1", 2, HOST_EMU_TILE_IN);
+  ObjectFifo<int32_t> of_in_inner("in1_inner", 2, HOST_EMU_TILE_IN);
+  ObjectFifo<int32_t> trans("trans", 2, HOST_EMU_TILE_OUT);
+  ObjectFifo<int32_t> of_numer_els("of_numer_els", 2, 1);
+  ObjectFifo<int32_t> of_out1("out", 2, HOST_EMU_TILE_OUT);
+  ObjectFifo<int32_t> of_done("outdone", 2, 16);
+
+  std::mutex err_m;
+  std::string error;
+  bool deadlock = false;
+  auto guarded = [&](auto body) {
+    return [&, body]() {
+      try {
+        body();
+      } catch (const host_aie::lock_timeout &e) {
+        {
+          std::lock_guard<std::mutex> lk(err_m);
+          if (error.empty())
+            error = e.what() + std::string(" (") + table.name(e.lock_id) + ")";
+          deadlock = true;
+        }
+        table.shutdown();
+      } catch (const host_aie::lock_shutdown &) {
+        // torn down because another thread failed
+      } catch (const std::exception &e) {
+        {
+          std::lock_guard<std::mutex> lk(err_m);
+          if (error.empty())
+            error = e.what();
+        }
+        table.shutdown();
+      }
+    };
+  };
+
+  int32_t join_cnt = 0;
+  uint64_t out_buffers = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+
+  // shim DMA tasks of the runtime sequence
+  std::thread shim_in(guarded([&]() {
+    for (int32_t i = 0; i < iters_outer; i++) {
+      int32_t *dst = of_in1.acquire(Port::Produce);
+      std::memcpy(dst, a + (int64_t)i * HOST_EMU_TILE_IN,
+                  HOST_EMU_TILE_IN * sizeof(int32_t));
+      of_in1.release(Port::Produce);
+    }
+  }));
+  std::thread shim_in_inner(guarded([&]() {
+    for (int64_t p = 0; p < n_parts; p++)
+      for (int32_t t = 0; t < transfers_inner; t++)
+        for (int32_t j = 0; j < iters_inner; j++) {
+          int32_t *dst = of_in_inner.acquire(Port::Produce);
+          std::memcpy(dst, b + p * part_elements + (int64_t)j * HOST_EMU_TILE_IN,
+                      HOST_EMU_TILE_IN * sizeof(int32_t));
+          of_in_inner.release(Port::Produce);
+        }
+  }));
+  std::thread shim_out([&]() {
+    int64_t offset = 0;
+    while (int32_t *src = of_out1.acquire_until_shutdown(Port::Consume)) {
+      int64_t n = std::min<int64_t>(HOST_EMU_TILE_OUT, out_size - offset);
+      if (n > 0)
+        std::memcpy(out + offset, src, n * sizeof(int32_t));
+      offset += HOST_EMU_TILE_OUT;
+      out_buffers++;
+      of_out1.release(Port::Consume);
+    }
+  });
+
+  // core_body_02
+  std::thread core02(guarded([&]() {
+    for (int32_t i = 0; i < iters_outer; i++) {
+      int32_t *elem_in = of_in1.acquire(Port::Consume);
+      for (int32_t j = 0; j < iters_inner; j++) {
+        int32_t *elem_inner = of_in_inner.acquire(Port::Consume);
+        int32_t *elem_out = trans.acquire(Port::Produce);
+        int32_t *numer_el = of_numer_els.acquire(Port::Produce);
+        odd_even(elem_in, elem_inner, elem_out, HOST_EMU_TILE_IN, numer_el);
+        of_numer_els.release(Port::Produce);
+        trans.release(Port::Produce);
+        of_in_inner.release(Port::Consume);
+      }
+      of_in1.release(Port::Consume);
+    }
+  }));
+
+  // core_body_12
+  std::thread core12(guarded([&]() {
+    writeout(trans.get_buffer(0), trans.get_buffer(1),
+             of_numer_els.get_buffer(0), of_numer_els.get_buffer(1),
+             of_out1.get_buffer(0), of_out1.get_buffer(1),
+             trans.acq_lock(Port::Consume), trans.rel_lock(Port::Consume),
+             of_numer_els.acq_lock(Port::Consume),
+             of_numer_els.rel_lock(Port::Consume),
+             of_out1.acq_lock(Port::Produce), of_out1.rel_lock(Port::Produce),
+             &join_cnt, iters_outer, iters_inner);
+    int32_t *elem_done = of_done.acquire(Port::Produce);
+    for (int i = 0; i < 16; i++)
+      elem_done[i] = 77;
+    elem_done[0] = join_cnt;
+    of_done.release(Port::Produce);
+  }));
+
+  // dma_await_task(done_task)
+  std::thread shim_done(guarded([&]() {
+    int32_t *src = of_done.acquire(Port::Consume);
+    std::memcpy(done, src, 16 * sizeof(uint32_t));
+    of_done.release(Port::Consume);
+  }));
+
+  shim_in.join();
+  shim_in_inner.join();
+  core02.join();
+  core12.join();
+  shim_done.join();
+  // everything the writeout released is already counted on the out lock,
+  // the drain empties it before it sees the shutdown
+  table.shutdown();
+  shim_out.join();
+  auto stop = std::chrono::high_resolution_clock::now();
+
+  if (stats) {
+    stats->seconds = std::chrono::duration<double>(stop - start).count();
+    stats->out_buffers = out_buffers;
+    stats->deadlock = deadlock;
+    stats->error = error;
+    stats->locks.clear();
+    for (size_t i = 0; i < table.size(); i++) {
+      host_aie::Semaphore &s = table[(int32_t)i];
+      stats->locks.push_back({table.name((int32_t)i), s.acquires(),
+                              s.blocked(), s.wait_ns() / 1e6});
+    }
+  }
+  return error.empty();
+}
+
+#endif
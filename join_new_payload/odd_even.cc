@@ -0,0 +1,185 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <type_traits>
+#include <algorithm>
+#ifndef AIE_HOST_EMULATION
+#include <aie_api/aie.hpp>
+#include <aie_api/utils.hpp>
+#endif
+#include "aie_kernel_utils.h"
+#include "aie_objectfifo.h"
+#include "../join_utils/compress.h"
+
+
+
+
+
+extern "C" {
+
+
+void writeout(
+            int32_t * restrict in_buf0, int32_t * restrict in_buf1,
+            int32_t * restrict in_of_numer0, int32_t * in_of_numer1,
+            int32_t * restrict out_buf0,int32_t * restrict out_buf1,
+            int64_t in_acq_lock,int64_t in_rel_lock,
+            int64_t in_of_numer_acq_lock,int64_t in_of_numer_rel_lock,
+            int64_t out_acq_lock, int64_t out_rel_lock,
+            int32_t * restrict elems_produced,
+            const int32_t iters_outer,
+            const int32_t iters_inner
+            ) {
+            *elems_produced =0;
+
+            objectfifo_t of_in = {(int32_t)in_acq_lock, (int32_t)in_rel_lock, -1, 1, 2,
+                                {in_buf0, in_buf1}};
+            objectfifo_t of_in_of_numer = {(int32_t)in_of_numer_acq_lock, (int32_t)in_of_numer_rel_lock, -1, 1, 2,
+                                {in_of_numer0, in_of_numer1}};
+
+            objectfifo_t of_out = {(int32_t)out_acq_lock, (int32_t)out_rel_lock, -1, 1, 2,
+                                 {out_buf0, out_buf1}};
+
+
+            objectfifo_acquire(&of_out);
+            int32_t *out = (int32_t *)objectfifo_get_buffer(&of_out, 0);
+            int freeOutBuf = 4096;
+            int outCount = 0;
+            int count_out_ac = 1;
+
+            //262144
+            //for (int i = 0; i < 65536; i++) {
+            //todo why are two loops not possible
+            for (int64_t i = 0; i < ((int64_t)iters_outer)*(int64_t)iters_inner; i++) {
+
+            //for (int i = 0; i < 512; i++) {
+            //for (int z = 0; z < 512; z++) {
+                objectfifo_acquire(&of_in);
+                int32_t *input = (int32_t *)objectfifo_get_buffer(&of_in, i);
+
+                objectfifo_acquire(&of_in_of_numer);
+                int32_t *numer_el = (int32_t *)objectfifo_get_buffer(&of_in_of_numer, i);
+                //event0();
+                *elems_produced += *numer_el;
+
+                auto to_copy = std::min(*numer_el,freeOutBuf);
+
+
+
+              for (int j = 0; j < to_copy; j += 1) // Nx samples per loop
+              {
+                out[j+outCount] = input[j];
+              }
+              freeOutBuf = freeOutBuf - to_copy;
+              outCount = outCount + to_copy;
+
+              if(freeOutBuf == 0){
+
+                objectfifo_release(&of_out);
+                objectfifo_acquire(&of_out);
+                out = (int32_t *)objectfifo_get_buffer(&of_out, count_out_ac);
+                count_out_ac ++;
+
+                freeOutBuf = 4096;
+                outCount =0;
+                for (int j = 0; j < ((*numer_el) - to_copy); j += 1) // Nx samples per loop
+                {
+                out[j] = input[j+to_copy];
+                }
+                freeOutBuf = freeOutBuf -((*numer_el) - to_copy);
+                outCount = outCount + ((*numer_el) - to_copy);
+              }
+                //event1();
+
+                objectfifo_release(&of_in_of_numer);
+                objectfifo_release(&of_in);
+
+            }//}
+            for (int j = outCount; j < 4096; j += 1){
+            out[j] = -1;
+            }
+            objectfifo_release(&of_out);
+
+         }
+
+
+
+
+
+//key + payload join: a tile holds 32 rows as 32 keys followed by their 32
+//(4 byte) payloads. Every match writes the triple (key, payload_a,
+//payload_b), so no gather pass is needed on the host afterwards.
+//*elems_produced counts words (3 per match), writeout only copies words.
+//n_a / n_b are the valid rows of the two tiles, 32 except for the tail tile
+//of a relation, the rest never matches.
+#ifdef AIE_HOST_EMULATION
+//scalar model of the vector kernel below for the host emulation,
+//writes the triples in the same order (outer row major, inner row minor)
+void odd_even_payload(int32_t * restrict input, int32_t * restrict input1,  int32_t * restrict value,const int32_t n_a,const int32_t n_b,int32_t * restrict elems_produced) {
+   int join_count = 0;
+   for (int i = 0; i < n_a; i++) {
+      for (int j = 0; j < n_b; j++) {
+        if (input[i] == input1[j]) {
+          value[3 * join_count] = input[i];
+          value[3 * join_count + 1] = input[32 + i];
+          value[3 * join_count + 2] = input1[32 + j];
+          join_count++;
+        }
+      }
+   }
+   *elems_produced = 3 * join_count;
+}
+#else
+//lanes of the j-th 16 element vector of B that hold valid rows
+static inline aie::mask<16> valid_lanes(int32_t n_b, int j) {
+  int32_t n = n_b - 16 * j;
+  uint32_t bits = n >= 16 ? 0xFFFFu : (n <= 0 ? 0u : (1u << n) - 1);
+  return aie::mask<16>::from_uint32(bits);
+}
+
+void odd_even_payload(int32_t * restrict input, int32_t * restrict input1,  int32_t * restrict value,const int32_t n_a,const int32_t n_b,int32_t * restrict elems_produced) {
+  //event0();
+   int join_count = 0;
+   int32_t *__restrict valuev = value;
+   alignas(aie::vector_decl_align) int32_t comp[16];
+
+   aie::mask<16> valid0 = valid_lanes(n_b, 0);
+   aie::mask<16> valid1 = valid_lanes(n_b, 1);
+
+   aie::vector<int32_t, 16> B0 = aie::load_v<16>(input1);
+   aie::vector<int32_t, 16> B1 = aie::load_v<16>(input1 + 16);
+   aie::vector<int32_t, 16> P0 = aie::load_v<16>(input1 + 32);
+   aie::vector<int32_t, 16> P1 = aie::load_v<16>(input1 + 48);
+
+   //the payloads of B are compacted on the vector unit, the triples are
+   //interleaved with scalar stores, matches are rare per key
+   auto emit = [&](aie::vector<int32_t, 16> B, aie::vector<int32_t, 16> P,
+                   aie::mask<16> valid, int32_t key, int32_t payload_a) {
+      auto mask = aie::eq(B, key) & valid;
+      int k = mask.count();
+      if (k == 0)
+        return;
+      compress_plan plan = compress_plan16(mask.to_uint32());
+      aie::store_v(comp, compress16(P, plan, -1));
+      for (int t = 0; t < k; t++) {
+        valuev[0] = key;
+        valuev[1] = payload_a;
+        valuev[2] = comp[t];
+        valuev += 3;
+      }
+      join_count += k;
+   };
+
+  AIE_PREPARE_FOR_PIPELINING
+   for (int a = 0; a < n_a; a++) {
+      int32_t key = input[a];
+      int32_t payload_a = input[32 + a];
+      emit(B0, P0, valid0, key, payload_a);
+      emit(B1, P1, valid1, key, payload_a);
+   }
+
+ *elems_produced = 3 * join_count;
+//event1();
+}
+#endif
+
+} // extern "C"
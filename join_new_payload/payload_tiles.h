@@ -0,0 +1,32 @@
+//===- payload_tiles.h ------------------------------------------*- C++ -*-===//
+//
+// Host layout of the key + payload relations of aie2.py: per tile of 32
+// rows, 32 keys followed by their 32 payloads. The kernel loads the keys as
+// two vectors and finds the payload of row r of a tile at r + 32.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef PAYLOAD_TILES_H
+#define PAYLOAD_TILES_H
+
+#include <cstdint>
+
+constexpr int64_t PAYLOAD_TILE_ROWS = 32;
+
+// words of the device buffer for n rows, padded to whole tiles
+inline int64_t payload_tile_words(int64_t n) {
+  return (n + PAYLOAD_TILE_ROWS - 1) / PAYLOAD_TILE_ROWS * 2 * PAYLOAD_TILE_ROWS;
+}
+
+// Writes keys / payloads[0 .. n) into dst in the tile layout, the padding
+// of the tail tile is left as it is (the kernel masks it).
+inline void pack_payload_tiles(const int32_t *keys, const int32_t *payloads,
+                               int64_t n, int32_t *dst) {
+  for (int64_t i = 0; i < n; i++) {
+    int64_t tile = i / PAYLOAD_TILE_ROWS, r = i % PAYLOAD_TILE_ROWS;
+    dst[tile * 2 * PAYLOAD_TILE_ROWS + r] = keys[i];
+    dst[tile * 2 * PAYLOAD_TILE_ROWS + PAYLOAD_TILE_ROWS + r] = payloads[i];
+  }
+}
+
+#endif
@@ -0,0 +1,490 @@
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include<unordered_map>
+
+
+#include "cxxopts.hpp"
+#include "test_utils.h"
+#include "hash_join.h"
+#include "bench.h"
+#include "datagen.h"
+#include "join_verify.h"
+#include "payload_tiles.h"
+#include "exec_backend.h"
+#include "host_emu.h"
+
+#ifndef JOIN_NO_XRT
+#include "xrt_backend.h"
+#include "xrt/xrt_graph.h"
+#endif
+
+
+#ifndef DATATYPES_USING_DEFINED
+#define DATATYPES_USING_DEFINED
+using DATATYPE = std::int32_t;
+#endif
+
+
+uint32_t getParity(uint32_t n) {
+  int count = 0;
+  while (n > 0) {
+    if (n & 1) { // Check if the least significant bit is 1
+      count++;
+    }
+    n >>= 1; // Right shift to check the next bit
+  }
+  return (count % 2 == 0) ? 0 : 1; // 0 for even parity, 1 for odd parity
+}
+
+uint32_t create_ctrl_pkt(int operation, int beats, int addr,
+                         int ctrl_pkt_read_id = 28) {
+  uint32_t ctrl_pkt = ((ctrl_pkt_read_id & 0xFF) << 24) |
+                      ((operation & 0x3) << 22) | ((beats & 0x3) << 20) |
+                      (addr & 0x7FFFF);
+  ctrl_pkt |= (0x1 ^ getParity(ctrl_pkt)) << 31;
+  return ctrl_pkt;
+}
+
+int main(int argc, const char *argv[]) {
+  // Program arguments parsing
+  cxxopts::Options options("odd_even Kernel");
+  test_utils::add_default_options(options);
+  options.add_option("","e","host_elements", "host elements (assumed to be 4 bytes)",
+      cxxopts::value<int64_t>()->default_value("1024"),"host elements");
+
+  options.add_option("","","size_a", "elements of the outer relation A, 0 means host_elements, must match aie2.py",
+      cxxopts::value<int64_t>()->default_value("0"),"size a");
+
+  options.add_option("","","size_b", "elements of the inner relation B, 0 means host_elements, must match aie2.py",
+      cxxopts::value<int64_t>()->default_value("0"),"size b");
+
+  options.add_option("","d","dist", "key domain, keys are drawn from 1 .. dist (uniform, zipf, no_match), selectivity 1/dist by default",
+      cxxopts::value<int32_t>()->default_value("100"),"distribution value");
+
+  options.add_option("","","key_dist", "key distribution: uniform, zipf, foreign_key, selectivity, all_equal, no_match",
+      cxxopts::value<std::string>()->default_value("uniform"),"key distribution");
+
+  options.add_option("","","selectivity", "join selectivity of --key_dist=selectivity, 0 means 1/dist",
+      cxxopts::value<double>()->default_value("0"),"selectivity");
+
+  options.add_option("","","zipf_s", "skew of --key_dist=zipf",
+      cxxopts::value<double>()->default_value("1.0"),"zipf exponent");
+
+  options.add_option("","","seed", "seed of the input generator",
+      cxxopts::value<uint64_t>()->default_value("12345"),"seed");
+
+  options.add_option("","b","backend", "execution backend: xrt or cpu (host emulation of the design)",
+      cxxopts::value<std::string>()->default_value("xrt"),"backend");
+
+  options.add_option("","s","sync_prefix", "skip the output pre-clear and sync back only the bufDone[0] prefix of the output",
+      cxxopts::value<bool>()->default_value("false"),"sync prefix");
+
+  options.add_option("","","variant", "design name the benchmark record is tagged with",
+      cxxopts::value<std::string>()->default_value("join_new_payload"),"variant");
+
+  options.add_option("","","compiler", "kernel compiler the benchmark record is tagged with (peano, xchesscc, cpu)",
+      cxxopts::value<std::string>()->default_value("unknown"),"compiler");
+
+  options.add_option("","","bench_csv", "CSV file the benchmark record is appended to, empty for none",
+      cxxopts::value<std::string>()->default_value("bench.csv"),"bench csv");
+
+  options.add_option("","","bench_json", "file the benchmark record is appended to as a JSON line, empty for none",
+      cxxopts::value<std::string>()->default_value(""),"bench json");
+
+  cxxopts::ParseResult vm;
+  test_utils::parse_options(argc, argv, options, vm);
+  int verbosity = vm["verbosity"].as<int>();
+  int n_iterations = vm["iters"].as<int>();
+  int n_warmup_iterations = vm["warmup"].as<int>();
+  int trace_size = vm["trace_sz"].as<int>();
+  std::string trace_file = vm["trace_file"].as<std::string>();
+
+  join_utils::DataGenConfig gen_config;
+  gen_config.domain = vm["dist"].as<int>();
+  gen_config.dist = join_utils::parse_key_dist(vm["key_dist"].as<std::string>());
+  gen_config.selectivity = vm["selectivity"].as<double>();
+  gen_config.zipf_s = vm["zipf_s"].as<double>();
+  gen_config.seed = vm["seed"].as<uint64_t>();
+  std::string backend_name = vm["backend"].as<std::string>();
+  bool sync_prefix = vm["sync_prefix"].as<bool>();
+
+  // Declaring design constants
+  constexpr bool VERIFY = true;
+  constexpr bool PRINT_OUT_BUFFERS = false;
+  //constexpr int64_t oneMBElements = 2*128*1024;
+  //not quite one GB 128MB otherwise timeout happens
+  //constexpr int64_t oneGBElements =  2048 * oneMBElements;
+  int64_t host_elements = vm["host_elements"].as<int64_t>();
+   std::cout << "host_elements: " << host_elements << "\n";
+  //A and B may differ and need not be multiples of 64, the buffers are
+  //padded to whole tiles and the kernel masks the tail tile
+  int64_t IN_SIZE_A = vm["size_a"].as<int64_t>() > 0 ? vm["size_a"].as<int64_t>() : host_elements;
+  int64_t IN_SIZE_B = vm["size_b"].as<int64_t>() > 0 ? vm["size_b"].as<int64_t>() : host_elements;
+  //device words of the key + payload tiles, padded to whole tiles
+  int64_t PADDED_SIZE_A = payload_tile_words(IN_SIZE_A);
+  int64_t PADDED_SIZE_B = payload_tile_words(IN_SIZE_B);
+  std::cout << "size_a: " << IN_SIZE_A << " size_b: " << IN_SIZE_B << "\n";
+  //int64_t OUT_SIZE = IN_SIZE *IN_SIZE;
+  //one GB
+  int64_t OUT_SIZE =  268435456;
+  bool enable_ctrl_pkts = false;
+
+
+  std::unique_ptr<join_utils::ExecBackend> backend;
+  if (backend_name == "cpu") {
+    //same tiling as aie2.py, the cores run as host threads
+    backend = std::make_unique<join_utils::CpuBackend>(
+        [IN_SIZE_A, IN_SIZE_B, OUT_SIZE](const std::vector<join_utils::Buffer *> &args) {
+          HostEmuStats stats;
+          bool ok = run_join_design_on_host(
+              args[0]->map<DATATYPE>(), IN_SIZE_A, args[1]->map<DATATYPE>(),
+              IN_SIZE_B, args[2]->map<DATATYPE>(), OUT_SIZE,
+              args[3]->map<uint32_t>(), &stats);
+          if (!ok)
+            std::cout << "host emulation failed: " << stats.error << "\n";
+          return ok;
+        });
+  } else {
+#ifndef JOIN_NO_XRT
+    // Load instruction sequence
+    std::vector<uint32_t> instr_v =
+        test_utils::load_instr_binary(vm["instr"].as<std::string>());
+
+    if (verbosity >= 1)
+      std::cout << "Sequence instr count: " << instr_v.size() << "\n";
+
+    // Start the XRT context and load the kernel
+    backend = std::make_unique<join_utils::XrtBackend>(
+        verbosity, vm["xclbin"].as<std::string>(),
+        vm["kernel"].as<std::string>(), instr_v);
+#else
+    std::cout << "built without XRT, only --backend=cpu is available\n";
+    return 1;
+#endif
+  }
+  std::cout << "backend: " << backend->name() << "\n";
+
+  // set up the buffer objects
+  auto bo_inA = backend->alloc(PADDED_SIZE_A * sizeof(DATATYPE), 3);
+
+  auto bo_inB = backend->alloc(PADDED_SIZE_B * sizeof(DATATYPE), 4);
+  auto bo_outC = backend->alloc(OUT_SIZE * sizeof(DATATYPE), 5);
+
+  // If we enable control packets, then this is the input xrt buffer for that.
+  // Otherwise, this is a dummy placedholder buffer.
+    //todo why do we need this?
+   auto bo_done = backend->alloc(16 * sizeof(uint32_t), 6);
+
+  // Workaround so we declare a really small trace buffer when one is not used
+  // Second workaround for driver issue. Allocate large trace buffer *4
+  // This includes the 8 bytes needed for control packet response.
+  //todo why 4* because of a segfault in the driver?
+  int tmp_trace_size = (trace_size > 0) ? trace_size * 4  : 1;
+  auto bo_trace = backend->alloc(tmp_trace_size, 7);
+
+  if (verbosity >= 1)
+    std::cout << "Writing data into buffer objects.\n";
+
+  // Initialize buffer bo_inA
+
+  DATATYPE *bufInA = bo_inA->map<DATATYPE>();
+  memset(bufInA, 0, PADDED_SIZE_A * sizeof(DATATYPE));
+
+   DATATYPE *bufInB = bo_inB->map<DATATYPE>();
+  memset(bufInB, 0, PADDED_SIZE_B * sizeof(DATATYPE));
+
+  // Zero out buffer bo_outC
+  DATATYPE *bufOut = bo_outC->map<DATATYPE>();
+  if (!sync_prefix)
+    memset(bufOut, 0, OUT_SIZE * sizeof(DATATYPE));
+
+
+
+  char *bufTrace = bo_trace->map<char>();
+
+
+
+  //the keys, the payload is the row number so that every triple the
+  //design writes can be checked against the inputs
+  std::vector<DATATYPE> keysA(IN_SIZE_A), keysB(IN_SIZE_B);
+  std::vector<DATATYPE> rowsA(IN_SIZE_A), rowsB(IN_SIZE_B);
+  for (int64_t i = 0; i < IN_SIZE_A; i++)
+    rowsA[i] = (DATATYPE)i;
+  for (int64_t i = 0; i < IN_SIZE_B; i++)
+    rowsB[i] = (DATATYPE)i;
+
+  uint32_t *bufDone = bo_done->map<uint32_t>();
+  memset(bufDone, 0, 16 * sizeof(uint32_t));
+
+
+  // sync host to device memories
+  bo_inA->sync(join_utils::SyncDir::ToDevice);
+  if (!sync_prefix)
+    bo_outC->sync(join_utils::SyncDir::ToDevice);
+  bo_inB->sync(join_utils::SyncDir::ToDevice);
+
+  bo_done->sync(join_utils::SyncDir::ToDevice);
+
+  if (trace_size > 0) {
+    bo_trace->sync(join_utils::SyncDir::ToDevice);
+
+  }
+
+
+
+  // Execute the kernel and wait to finish
+  int errors = 0;
+  unsigned num_iter = n_iterations + n_warmup_iterations;
+  join_utils::Bench bench(n_warmup_iterations);
+  float npu_time_total = 0;
+  float npu_time_min = 9999999;
+  float npu_time_max = 0;
+  float selectivi = 0;
+
+  float cpu_time_total = 0;
+
+
+
+  //keys are generated by all host threads straight into the inputs, a new
+  //set every iteration
+  join_utils::DataGen<DATATYPE> datagen(gen_config);
+
+
+  for (int iter = 0; iter < num_iter; iter++) {
+    //todo put back warmup iterrations
+     std::cout << "iter: " << iter <<"\n";
+
+      if (verbosity >= 1) {
+      std::cout << "Setting inputs and zero out out buffers ..." << std::endl;
+    }
+
+       /*
+      for (int64_t i = 0; i < IN_SIZE_A; i++)
+        keysA[i] =   iter +1; //plus one for first iteration
+
+       for (int64_t i = 0; i < IN_SIZE_B; i++)
+        keysB[i] =   iter +1; //plus one for first iteration
+        */
+
+      datagen.fill(keysA.data(), IN_SIZE_A, keysB.data(), IN_SIZE_B, iter);
+
+      pack_payload_tiles(keysA.data(), rowsA.data(), IN_SIZE_A, bufInA);
+      pack_payload_tiles(keysB.data(), rowsB.data(), IN_SIZE_B, bufInB);
+
+
+
+
+
+      // Zero out buffer bo_outC
+      // not needed with sync_prefix, only the reported prefix is ever read
+      if (!sync_prefix)
+        memset(bufOut, -1, OUT_SIZE * sizeof(DATATYPE));
+
+      memset(bufDone, 0, 16 * sizeof(uint32_t));
+
+      if (trace_size > 0 ) {
+          //zero out buffTrace each iteration???
+          memset(bufTrace,0,tmp_trace_size*sizeof(char));
+          bo_trace->sync(join_utils::SyncDir::ToDevice);
+      }
+      //this should not be needed
+      //bo_instr.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+      bo_inA->sync(join_utils::SyncDir::ToDevice);
+      bo_inB->sync(join_utils::SyncDir::ToDevice);
+      if (!sync_prefix)
+        bo_outC->sync(join_utils::SyncDir::ToDevice);
+      bo_done->sync(join_utils::SyncDir::ToDevice);
+
+
+    std::cout << "Running Kernel.\n";
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    auto run = backend->start(
+        {bo_inA.get(), bo_inB.get(), bo_outC.get(), bo_done.get(), bo_trace.get()});
+
+    bool completed = run->wait();
+    auto stop = std::chrono::high_resolution_clock::now();
+    if (!completed)
+      errors++;
+
+    // Sync device to host memories
+    if (sync_prefix) {
+      // the done count tells how much of the 1GB output was written
+      bo_done->sync(join_utils::SyncDir::FromDevice);
+      size_t out_bytes =
+          std::min<size_t>(bufDone[0], OUT_SIZE) * sizeof(DATATYPE);
+      if (out_bytes > 0)
+        bo_outC->sync(join_utils::SyncDir::FromDevice, out_bytes, 0);
+    } else {
+      bo_outC->sync(join_utils::SyncDir::FromDevice);
+
+      bo_done->sync(join_utils::SyncDir::FromDevice);
+    }
+
+
+    std::cout << "Print done:" << std::endl;
+
+    for (uint32_t i = 0; i < 16; i++) {
+       int32_t test = bufDone[i];
+       std::cout << test << " ";
+    }
+    std::cout  << "\n";
+
+    if (trace_size > 0)
+      bo_trace->sync(join_utils::SyncDir::FromDevice);
+
+    //todo should tmp_trace_size be used here?
+    if (trace_size > 0 ) {
+      test_utils::write_out_trace(((char *)bufTrace), trace_size,
+                                  trace_file);
+    }
+    // Accumulate run times
+    /* Warmup iterations do not count towards average runtime. */
+
+    float npu_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(stop - start)
+            .count();
+    std::cout << ""
+              << "NPU time: " << npu_time << "us."
+              << std::endl;
+
+  if (iter < n_warmup_iterations)
+      /* Warmup iterations do not count towards average runtime. */
+      continue;
+
+    npu_time_total += npu_time;
+    bench.add_npu(iter, npu_time);
+    npu_time_min = (npu_time < npu_time_min) ? npu_time : npu_time_min;
+    npu_time_max = (npu_time > npu_time_max) ? npu_time : npu_time_max;
+
+
+
+     if (PRINT_OUT_BUFFERS >= 1) {
+      std::cout << "Join:" << std::endl;
+
+      for (uint32_t i = 0; i < OUT_SIZE; i++) {
+      int32_t test = bufOut[i];
+      std::cout << test << " ";
+    }
+
+    }
+
+    // Compare out to golden
+
+    if(VERIFY){
+        if (verbosity >= 1) {
+            std::cout << "Verifying results ..." << std::endl;
+        }
+
+
+        auto start = std::chrono::high_resolution_clock::now();
+        join_utils::JoinResult<DATATYPE> ref =
+            join_utils::radix_hash_join(keysA.data(), IN_SIZE_A, keysB.data(), IN_SIZE_B);
+         auto stop = std::chrono::high_resolution_clock::now();
+         float cpu_time =
+        std::chrono::duration_cast<std::chrono::microseconds>(stop - start)
+            .count();
+          std::cout << ""
+              << "CPU time: " << cpu_time << "us."
+              << std::endl;
+          cpu_time_total += cpu_time;
+          bench.add_cpu(iter, cpu_time);
+
+         std::cout << ""
+              << "ref.size(): " << ref.matches.size() << ""
+              << std::endl;
+         std::cout << ""
+              << "selectivity: " << (double)ref.matches.size() / (IN_SIZE_A*IN_SIZE_B) << ""
+              << std::endl;
+        selectivi = (double)ref.matches.size() / (IN_SIZE_A*IN_SIZE_B);
+
+        //only the prefix reported by the writeout core holds join results
+        size_t n_out = bufDone[0];
+        if (n_out > (size_t)OUT_SIZE) {
+            std::cout << "join count " << n_out << " exceeds OUT_SIZE " << OUT_SIZE << "\n";
+            n_out = OUT_SIZE;
+        }
+
+        //bufDone[0] counts words, one (key, payload_a, payload_b) per match
+        join_utils::PairVerifyResult check = join_utils::verify_row_triples(
+            bufOut, n_out / 3, keysA.data(), IN_SIZE_A, keysB.data(), IN_SIZE_B,
+            ref.matches.size());
+
+        if(check.equal && n_out % 3 == 0){
+            std::cout << "equal"<< "\n";
+        }else{
+            std::cout << "not equal"<< "\n";
+            if (check.index < n_out / 3)
+              std::cout << "first bad triple at " << check.index << ": "
+                        << bufOut[3 * check.index] << " "
+                        << bufOut[3 * check.index + 1] << " "
+                        << bufOut[3 * check.index + 2] << "\n";
+            std::cout << "expected triples: " << check.expected
+                      << " got: " << check.got << " (" << n_out << " words)\n";
+            errors++;
+        }
+
+
+
+
+    }
+
+
+
+
+  }
+
+  // print out profiling result
+  std::cout << std::endl
+          << "Number of iterations: " << n_iterations
+          << " (warmup iterations: " << n_warmup_iterations << ")"
+          << std::endl;
+
+  std::cout << std::endl
+            << "Avg NPU time: " << npu_time_total / n_iterations << "us."
+            << std::endl;
+
+std::cout << std::endl
+            << "Avg CPU time: " << cpu_time_total / n_iterations << "us."
+            << std::endl;
+
+
+
+    join_utils::BenchRecord record;
+    record.variant = vm["variant"].as<std::string>();
+    record.compiler = backend_name == "cpu" ? "cpu" : vm["compiler"].as<std::string>();
+    record.backend = backend->name();
+    record.size_a = IN_SIZE_A;
+    record.size_b = IN_SIZE_B;
+    record.selectivity = selectivi;
+    record.cores = 2;
+    record.results = (uint64_t)std::llround(selectivi * (double)IN_SIZE_A * (double)IN_SIZE_B);
+    //inputs and the (key, payload_a, payload_b) triples
+    record.bytes = (IN_SIZE_A + IN_SIZE_B + 3 * record.results) * sizeof(DATATYPE);
+    record.warmup = n_warmup_iterations;
+    record.npu = bench.npu();
+    record.cpu = bench.cpu();
+    join_utils::bench_print(std::cout, record);
+    if (!join_utils::bench_append_csv(vm["bench_csv"].as<std::string>(), record) ||
+        !join_utils::bench_append_json(vm["bench_json"].as<std::string>(), record))
+      std::cout << "could not write the benchmark record\n";
+
+  // Print Pass/Fail result of our test
+  if (!errors) {
+    std::cout << std::endl << "PASS!" << std::endl << std::endl;
+
+    return 0;
+  } else {
+    std::cout << std::endl
+              << errors << " mismatches." << std::endl
+              << std::endl;
+    std::cout << std::endl << "fail." << std::endl << std::endl;
+    //return 1;
+  }
+}
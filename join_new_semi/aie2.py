@@ -0,0 +1,280 @@
+from pkgutil import extend_path
+
+import numpy as np
+import sys
+import aie.utils.trace as trace_utils
+
+from aie.dialects.aie import *
+from aie.dialects.aiex import *
+from aie.helpers.dialects.scf import _for as range_, if_, else_
+from aie.extras.context import mlir_mod_ctx
+from setuptools.archive_util import extraction_drivers
+
+#use stderr so the mlir output does not break
+#These are don't have to be errors
+def eprint(*args, **kwargs):
+    print(*args, file=sys.stderr, **kwargs)
+
+if len(sys.argv) > 1:
+    if sys.argv[1] == "npu":
+        dev = AIEDevice.npu1
+    elif sys.argv[1] == "npu2":
+        dev = AIEDevice.npu2
+    else:
+        raise ValueError("[ERROR] Device name {} is unknown".format(sys.argv[1]))
+
+trace_size = 0
+if len(sys.argv) > 2:
+    if sys.argv[2].isdigit():
+        trace_size = int(sys.argv[2])
+        eprint("[INFO] trace_size: {}".format(trace_size))
+    else:
+        eprint("[Info] sys.argv[2] (trace_size):{} is not a positive number falling back to trace_size = 0".format(sys.argv[2]))
+
+host_elements = 1024
+if len(sys.argv) > 3:
+    if sys.argv[3].isdigit():
+        host_elements = int(sys.argv[3])
+        eprint("[INFO] host_elements: {}".format(host_elements))
+    else:
+        eprint("[Info] sys.argv[3] (host_elements):{} is not a positive number falling back to host_elements = 1024".format(sys.argv[3]))
+
+#sizes of the outer (A) and inner (B) relation, host_elements is the size of A
+size_a = host_elements
+size_b = host_elements
+if len(sys.argv) > 4:
+    if sys.argv[4].isdigit():
+        size_b = int(sys.argv[4])
+        eprint("[INFO] size_b: {}".format(size_b))
+    else:
+        eprint("[Info] sys.argv[4] (size_b):{} is not a positive number falling back to size_b = host_elements".format(sys.argv[4]))
+
+#0 semi join (EXISTS), 1 anti join (NOT EXISTS): the output bit of a row of A
+#is set if it has a partner in B, for the anti join if it has none
+anti = 0
+if len(sys.argv) > 5:
+    if sys.argv[5].isdigit():
+        anti = 1 if int(sys.argv[5]) else 0
+        eprint("[INFO] anti: {}".format(anti))
+    else:
+        eprint("[Info] sys.argv[5] (anti):{} is not a number falling back to anti = 0".format(sys.argv[5]))
+
+
+
+def external_mem_to_core():
+    with mlir_mod_ctx() as ctx:
+
+        @device(dev)
+        def device_body():
+
+
+
+
+
+            tile_ty_size_in = 64
+
+            #the host pads both relations to whole tiles, the last tile of
+            #each only has tail_a / tail_b valid elements
+            tiles_a = -(-size_a // tile_ty_size_in)
+            tiles_b = -(-size_b // tile_ty_size_in)
+            tail_a = size_a % tile_ty_size_in
+            tail_b = size_b % tile_ty_size_in
+
+            tranfer_size_elemnts_a = tiles_a * tile_ty_size_in
+            tranfer_size_elemnts_b = tiles_b * tile_ty_size_in
+            #two words of match bits per outer tile instead of up to 4096 keys
+            bitmap_size = 2
+            tranfer_size_elemnts_out = tiles_a * bitmap_size
+
+
+            eprint("[INFO] tranfer_size_elemnts_a: {}".format(tranfer_size_elemnts_a))
+            eprint("[INFO] tranfer_size_elemnts_b: {}".format(tranfer_size_elemnts_b))
+            eprint("[INFO] tranfer_size_elemnts_out: {}".format(tranfer_size_elemnts_out))
+
+            eprint("[INFO] tile_ty_size_in: {}".format(tile_ty_size_in))
+
+            #full tiles, the tail tiles are extra calls after the loops
+            iters_outer = size_a // tile_ty_size_in
+            iters_inner = size_b // tile_ty_size_in
+            #one relation needs to be pushed several times
+            transfers_inner = tiles_a
+
+            eprint("[INFO] iters_outer: {} tail_a: {}".format(iters_outer, tail_a))
+            eprint("[INFO] iters_inner: {} tail_b: {}".format(iters_inner, tail_b))
+
+            eprint("[INFO] transfers_inner: {}".format(transfers_inner))
+
+
+            tile_ty_in = np.ndarray[(tile_ty_size_in,), np.dtype[np.int32]]
+            bitmap_ty = np.ndarray[(bitmap_size,), np.dtype[np.int32]]
+
+            data_ty_a = np.ndarray[(tranfer_size_elemnts_a,), np.dtype[np.int32]]
+            data_ty_b = np.ndarray[(tranfer_size_elemnts_b,), np.dtype[np.int32]]
+            data_ty_out = np.ndarray[(tranfer_size_elemnts_out,), np.dtype[np.int32]]
+
+            ty_one_int = np.ndarray[(1,), np.dtype[np.int32]]
+
+            # External, binary kernel definition
+            odd_even_semi = external_func(
+                "odd_even_semi",
+                inputs=[tile_ty_in, tile_ty_in, np.int32, np.int32, bitmap_ty]
+            )
+
+            bitmap_flush = external_func(
+                "bitmap_flush",
+                inputs=[bitmap_ty, bitmap_ty, np.int32, np.int32, ty_one_int]
+            )
+
+            # Tile declarations
+            ShimTile00 = tile(0, 0)
+            ShimTile10 = tile(1, 0)
+            ShimTile20 = tile(2, 0)
+            MemTile01 = tile(0, 1)
+            ComputeTile02 = tile(0, 2)
+
+            # AIE-array data movement with object fifos
+            # Input
+            #tile_ty = np.ndarray[(host_elements,), np.dtype[np.int32]]
+
+            of_in_sh = object_fifo("in", ShimTile00, MemTile01, 2, tile_ty_in)
+            of_in_inner_sh = object_fifo("in_inner", ShimTile00, MemTile01, 2, tile_ty_in)
+
+            of_in1 = object_fifo("in1", MemTile01, ComputeTile02, 2, tile_ty_in)
+            of_in_inner = object_fifo("in1_inner", MemTile01, ComputeTile02, 2, tile_ty_in)
+            object_fifo_link(of_in_sh, of_in1)
+            object_fifo_link(of_in_inner_sh, of_in_inner)
+
+            # Output, only the match bits of every outer tile leave the core
+            of_bits = object_fifo("bits", ComputeTile02, ShimTile10, 2, bitmap_ty)
+
+            data_ty_done = np.ndarray[(16,), np.dtype[np.int32]]
+            of_done = object_fifo("outdone", ComputeTile02, ShimTile10, 2, data_ty_done)
+
+
+            bitmap = aie.buffer(
+                tile=ComputeTile02,
+                datatype=bitmap_ty,
+                name=f"bitmap",
+                initial_value=np.zeros(bitmap_size, dtype=np.int32)
+            )
+
+            selected = aie.buffer(
+                tile=ComputeTile02,
+                datatype=ty_one_int,
+                name=f"selected",
+                initial_value=np.array(0, dtype=np.int32)
+            )
+
+
+            # Set up compute tiles
+            # Compute tile
+            #one outer tile of A against all of B, the bitmap collects the
+            #matches over the inner tiles and goes out once per outer tile
+            def join_outer_tile(elem_in, n_a):
+                def inner_tile(n_b):
+                    elem_inner = of_in_inner.acquire(ObjectFifoPort.Consume, 1)
+                    call(odd_even_semi, [elem_in, elem_inner, n_a, n_b, bitmap])
+                    of_in_inner.release(ObjectFifoPort.Consume, 1)
+
+                for _ in range_(iters_inner):
+                    inner_tile(tile_ty_size_in)
+                if tail_b > 0:
+                    inner_tile(tail_b)
+
+                bits = of_bits.acquire(ObjectFifoPort.Produce, 1)
+                call(bitmap_flush, [bitmap, bits, n_a, anti, selected])
+                of_bits.release(ObjectFifoPort.Produce, 1)
+
+            @core(ComputeTile02, "odd_even.o",dynamic_objfifo_lowering=False)
+            def core_body_02():
+
+                for _ in range_(0xFFFFFFFF):
+                    selected[0] = 0
+                    bitmap[0] = 0
+                    bitmap[1] = 0
+                    for _ in range_(iters_outer):
+                        elem_in = of_in1.acquire(ObjectFifoPort.Consume, 1)
+                        join_outer_tile(elem_in, tile_ty_size_in)
+                        of_in1.release(ObjectFifoPort.Consume, 1)
+
+                    if tail_a > 0:
+                        elem_in = of_in1.acquire(ObjectFifoPort.Consume, 1)
+                        join_outer_tile(elem_in, tail_a)
+                        of_in1.release(ObjectFifoPort.Consume, 1)
+
+                    #number of selected rows of A
+                    elem_done = of_done.acquire(ObjectFifoPort.Produce, 1)
+                    for i in range_(16):
+                        elem_done[i] = 77
+                    elem_done[0] = selected[0]
+                    of_done.release(ObjectFifoPort.Produce, 1)
+
+
+
+
+
+
+
+
+            tiles_to_trace = [ComputeTile02]
+            if trace_size > 0:
+                trace_utils.configure_packet_tracing_flow(tiles_to_trace, ShimTile20)
+                #todo use other shimtile to trace?
+
+
+
+
+            @runtime_sequence(data_ty_a, data_ty_b,data_ty_out,data_ty_done)
+            def sequence(inTensor,innerinTensor,outOddTensor,doneTensor):
+
+                if trace_size > 0:
+                    trace_utils.configure_packet_tracing_aie2( #todo is this method correct form every npu?
+                        tiles_to_trace=tiles_to_trace,
+                        shim=ShimTile20,
+                        ddr_id=4,# 4 -> group_id(7)
+                        trace_size=trace_size,
+                    )
+
+
+
+
+                in_task = shim_dma_single_bd_task(of_in_sh, inTensor, offset= 0 ,sizes=[1, 1, 1, tranfer_size_elemnts_a],issue_token=False)
+                out_task = shim_dma_single_bd_task(
+                    of_bits, outOddTensor, offset=0, sizes=[1, 1, 1, tranfer_size_elemnts_out], issue_token=True
+                )
+
+                done_task = shim_dma_single_bd_task(
+                    of_done, doneTensor, offset=0, sizes=[1, 1, 1, 16], issue_token=True, burst_length=64
+                )
+
+                dma_start_task(in_task, out_task, done_task)
+
+                for i in range(transfers_inner):
+                    inner_in_task1 = shim_dma_single_bd_task(of_in_inner_sh, innerinTensor, offset=0,
+                                                      sizes=[1, 1, 1, tranfer_size_elemnts_b], issue_token=True)
+
+                    dma_start_task(inner_in_task1)
+                    dma_await_task(inner_in_task1)
+
+
+
+                #the bitmap is small, wait for all of it like for done
+                dma_await_task(out_task)
+                dma_await_task(done_task)
+                dma_free_task(in_task)
+
+                if trace_size > 0:
+                    trace_utils.gen_trace_done_aie2(ShimTile20)
+
+
+
+
+
+    res = ctx.module.operation.verify()
+    if res == True:
+        print(ctx.module)
+    else:
+        print(res)
+
+
+external_mem_to_core()
\ No newline at end of file
@@ -0,0 +1,104 @@
+//===- host_emu.cpp ---------------------------------------------*- C++ -*-===//
+//
+// Runs the semi / anti join design of this directory on x86 threads (see
+// host_emu.h), checks the bitmap against semi_join_bitmap and prints
+// throughput and per lock stall statistics. Exits with 1 on a mismatch or a
+// deadlock.
+//
+// ./host_emu.exe [size_a] [dist] [iters] [lock_timeout_ms] [size_b] [anti]
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "hash_join.h"
+#include "join_verify.h"
+#include "semi_join.h"
+#include "host_emu.h"
+
+using DATATYPE = std::int32_t;
+
+int main(int argc, const char *argv[]) {
+  int64_t size_a = argc > 1 ? std::atoll(argv[1]) : 1024;
+  int32_t upperdist = argc > 2 ? std::atoi(argv[2]) : 300;
+  int n_iterations = argc > 3 ? std::atoi(argv[3]) : 1;
+  int timeout_ms = argc > 4 ? std::atoi(argv[4]) : 10000;
+  int64_t size_b = argc > 5 ? std::atoll(argv[5]) : size_a;
+  bool anti = argc > 6 && std::atoi(argv[6]) != 0;
+
+  std::cout << "size_a: " << size_a << " size_b: " << size_b
+            << (anti ? " anti join\n" : " semi join\n");
+
+  host_aie::LockTable::get().timeout = std::chrono::milliseconds(timeout_ms);
+
+  int64_t OUT_SIZE = join_utils::bitmap_words(size_a);
+  std::vector<DATATYPE> bufInA(size_a), bufInB(size_b);
+  std::vector<DATATYPE> bufOut(OUT_SIZE);
+  uint32_t bufDone[16];
+
+  std::mt19937 rng(12345);
+  std::uniform_int_distribution<DATATYPE> dist(1, upperdist);
+
+  int errors = 0;
+  for (int iter = 0; iter < n_iterations; iter++) {
+    for (auto &x : bufInA)
+      x = dist(rng);
+    for (auto &x : bufInB)
+      x = dist(rng);
+
+    HostEmuStats stats;
+    bool ok = run_join_design_on_host(bufInA.data(), size_a, bufInB.data(),
+                                      size_b, anti, bufOut.data(), bufDone,
+                                      &stats);
+    if (!ok) {
+      std::cout << (stats.deadlock ? "deadlock: " : "error: ") << stats.error
+                << "\n";
+      errors++;
+    }
+
+    double comparisons = (double)size_a * size_b;
+    std::cout << "emulated time: " << stats.seconds * 1e6 << "us, "
+              << comparisons / stats.seconds / 1e6 << " Mcmp/s, "
+              << bufDone[0] << " rows selected, " << stats.out_buffers
+              << " bitmaps, " << stats.saturated_calls
+              << " calls with a full bitmap\n";
+    for (auto &l : stats.locks)
+      if (l.blocked)
+        std::cout << "  " << l.name << ": " << l.blocked << "/" << l.acquires
+                  << " acquires blocked, " << l.wait_ms << "ms waiting\n";
+
+    if (!ok)
+      continue;
+
+    std::vector<uint32_t> ref = join_utils::semi_join_bitmap(
+        bufInA.data(), size_a, bufInB.data(), size_b, anti);
+    const uint32_t *bits = reinterpret_cast<const uint32_t *>(bufOut.data());
+    join_utils::PairVerifyResult check =
+        join_utils::verify_bitmap(bits, ref.data(), ref.size());
+    if (check.equal &&
+        bufDone[0] != join_utils::bitmap_count(ref.data(), ref.size())) {
+      std::cout << "selected rows: " << bufDone[0] << " expected: "
+                << join_utils::bitmap_count(ref.data(), ref.size()) << "\n";
+      errors++;
+    } else if (check.equal) {
+      std::cout << "equal\n";
+    } else {
+      std::cout << "not equal, first differing row: " << check.index
+                << " expected: " << check.expected << " got: " << check.got
+                << "\n";
+      errors++;
+    }
+  }
+
+  if (!errors) {
+    std::cout << std::endl << "PASS!" << std::endl << std::endl;
+    return 0;
+  }
+  std::cout << std::endl << errors << " mismatches." << std::endl << std::endl;
+  std::cout << std::endl << "fail." << std::endl << std::endl;
+  return 1;
+}
@@ -0,0 +1,202 @@
+//===- host_emu.h -----------------------------------------------*- C++ -*-===//
+//
+// Runs the aie2.py design of this directory on the host: every core and
+// every shim DMA channel becomes a std::thread, every object fifo a
+// host_aie::ObjectFifo. core_body_02 calls the (scalar model of)
+// odd_even_semi and bitmap_flush from odd_even.cc, there is no writeout core.
+//
+// The MemTile hops (in -> in1) are folded into one fifo each, with the depth
+// of the compute tile side.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef HOST_EMU_H
+#define HOST_EMU_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "host_locks.h"
+
+extern "C" {
+void odd_even_semi(int32_t *input, int32_t *input1, const int32_t n_a,
+                   const int32_t n_b, int32_t *bitmap);
+void bitmap_flush(int32_t *bitmap, int32_t *out, const int32_t n_a,
+                  const int32_t anti, int32_t *selected);
+}
+
+struct HostEmuLockStats {
+  std::string name;
+  uint64_t acquires;
+  uint64_t blocked;
+  double wait_ms;
+};
+
+struct HostEmuStats {
+  double seconds = 0;
+  uint64_t out_buffers = 0;
+  // odd_even_semi calls that found all bits of the outer tile already set
+  uint64_t saturated_calls = 0;
+  bool deadlock = false;
+  std::string error;
+  std::vector<HostEmuLockStats> locks;
+};
+
+// Same constants as aie2.py
+constexpr int32_t HOST_EMU_TILE_IN = 64;
+constexpr int32_t HOST_EMU_BITMAP = 2;
+
+// Semi joins (anti joins with anti) a[0 .. n_a) with b[0 .. n_b) through the
+// emulated design, the last tile of each relation may be partial like in
+// aie2.py. out receives the two bitmap words of every outer tile, done the
+// 16 words of the outdone fifo. Returns false on a deadlock (lock acquire
+// timeout) or any other error.
+inline bool run_join_design_on_host(const int32_t *a, int64_t n_a,
+                                    const int32_t *b, int64_t n_b, bool anti,
+                                    int32_t *out, uint32_t *done,
+                                    HostEmuStats *stats) {
+  using host_aie::ObjectFifo;
+  using Port = ObjectFifo<int32_t>::Port;
+
+  // tiles including the partial tail tile
+  const int32_t iters_outer =
+      (int32_t)((n_a + HOST_EMU_TILE_IN - 1) / HOST_EMU_TILE_IN);
+  const int32_t iters_inner =
+      (int32_t)((n_b + HOST_EMU_TILE_IN - 1) / HOST_EMU_TILE_IN);
+  const int32_t transfers_inner = iters_outer;
+  auto valid = [](int64_t n, int32_t tile) {
+    return (int32_t)std::min<int64_t>(HOST_EMU_TILE_IN,
+                                      n - (int64_t)tile * HOST_EMU_TILE_IN);
+  };
+
+  host_aie::LockTable &table = host_aie::LockTable::get();
+  table.clear();
+
+  ObjectFifo<int32_t> of_in1("in1", 2, HOST_EMU_TILE_IN);
+  ObjectFifo<int32_t> of_in_inner("in1_inner", 2, HOST_EMU_TILE_IN);
+  ObjectFifo<int32_t> of_bits("bits", 2, HOST_EMU_BITMAP);
+  ObjectFifo<int32_t> of_done("outdone", 2, 16);
+
+  std::mutex err_m;
+  std::string error;
+  bool deadlock = false;
+  auto guarded = [&](auto body) {
+    return [&, body]() {
+      try {
+        body();
+      } catch (const host_aie::lock_timeout &e) {
+        {
+          std::lock_guard<std::mutex> lk(err_m);
+          if (error.empty())
+            error = e.what() + std::string(" (") + table.name(e.lock_id) + ")";
+          deadlock = true;
+        }
+        table.shutdown();
+      } catch (const host_aie::lock_shutdown &) {
+        // torn down because another thread failed
+      } catch (const std::exception &e) {
+        {
+          std::lock_guard<std::mutex> lk(err_m);
+          if (error.empty())
+            error = e.what();
+        }
+        table.shutdown();
+      }
+    };
+  };
+
+  uint64_t out_buffers = 0;
+  uint64_t saturated_calls = 0;
+  auto start = std::chrono::high_resolution_clock::now();
+
+  // shim DMA tasks of the runtime sequence
+  std::thread shim_in(guarded([&]() {
+    for (int32_t i = 0; i < iters_outer; i++) {
+      int32_t *dst = of_in1.acquire(Port::Produce);
+      std::memcpy(dst, a + (int64_t)i * HOST_EMU_TILE_IN,
+                  valid(n_a, i) * sizeof(int32_t));
+      of_in1.release(Port::Produce);
+    }
+  }));
+  std::thread shim_in_inner(guarded([&]() {
+    for (int32_t t = 0; t < transfers_inner; t++)
+      for (int32_t j = 0; j < iters_inner; j++) {
+        int32_t *dst = of_in_inner.acquire(Port::Produce);
+        std::memcpy(dst, b + (int64_t)j * HOST_EMU_TILE_IN,
+                    valid(n_b, j) * sizeof(int32_t));
+        of_in_inner.release(Port::Produce);
+      }
+  }));
+  std::thread shim_out(guarded([&]() {
+    for (int32_t i = 0; i < iters_outer; i++) {
+      int32_t *src = of_bits.acquire(Port::Consume);
+      std::memcpy(out + (int64_t)i * HOST_EMU_BITMAP, src,
+                  HOST_EMU_BITMAP * sizeof(int32_t));
+      out_buffers++;
+      of_bits.release(Port::Consume);
+    }
+  }));
+
+  // core_body_02
+  std::thread core02(guarded([&]() {
+    int32_t selected = 0;
+    int32_t bitmap[HOST_EMU_BITMAP] = {0, 0};
+    for (int32_t i = 0; i < iters_outer; i++) {
+      int32_t *elem_in = of_in1.acquire(Port::Consume);
+      uint64_t all = valid(n_a, i) == 64 ? ~0ull : (1ull << valid(n_a, i)) - 1;
+      for (int32_t j = 0; j < iters_inner; j++) {
+        int32_t *elem_inner = of_in_inner.acquire(Port::Consume);
+        uint64_t bits = (uint32_t)bitmap[0] | ((uint64_t)(uint32_t)bitmap[1] << 32);
+        saturated_calls += (bits & all) == all;
+        odd_even_semi(elem_in, elem_inner, valid(n_a, i), valid(n_b, j), bitmap);
+        of_in_inner.release(Port::Consume);
+      }
+      int32_t *bits = of_bits.acquire(Port::Produce);
+      bitmap_flush(bitmap, bits, valid(n_a, i), anti, &selected);
+      of_bits.release(Port::Produce);
+      of_in1.release(Port::Consume);
+    }
+    int32_t *elem_done = of_done.acquire(Port::Produce);
+    for (int i = 0; i < 16; i++)
+      elem_done[i] = 77;
+    elem_done[0] = selected;
+    of_done.release(Port::Produce);
+  }));
+
+  // dma_await_task(done_task)
+  std::thread shim_done(guarded([&]() {
+    int32_t *src = of_done.acquire(Port::Consume);
+    std::memcpy(done, src, 16 * sizeof(uint32_t));
+    of_done.release(Port::Consume);
+  }));
+
+  shim_in.join();
+  shim_in_inner.join();
+  core02.join();
+  shim_out.join();
+  shim_done.join();
+  auto stop = std::chrono::high_resolution_clock::now();
+
+  if (stats) {
+    stats->seconds = std::chrono::duration<double>(stop - start).count();
+    stats->out_buffers = out_buffers;
+    stats->saturated_calls = saturated_calls;
+    stats->deadlock = deadlock;
+    stats->error = error;
+    stats->locks.clear();
+    for (size_t i = 0; i < table.size(); i++) {
+      host_aie::Semaphore &s = table[(int32_t)i];
+      stats->locks.push_back({table.name((int32_t)i), s.acquires(),
+                              s.blocked(), s.wait_ns() / 1e6});
+    }
+  }
+  return error.empty();
+}
+
+#endif
@@ -0,0 +1,113 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <type_traits>
+#include <algorithm>
+#ifndef AIE_HOST_EMULATION
+#include <aie_api/aie.hpp>
+#include <aie_api/utils.hpp>
+#endif
+#include "aie_kernel_utils.h"
+#include "aie_objectfifo.h"
+
+
+
+
+
+extern "C" {
+
+//the bitmap buffer of the core holds the 64 match bits of the current outer
+//tile as two words, bit i of word w is outer element 32 * w + i
+static inline uint64_t load_bits(const int32_t * restrict bitmap) {
+  return (uint64_t)(uint32_t)bitmap[0] | ((uint64_t)(uint32_t)bitmap[1] << 32);
+}
+
+static inline void store_bits(int32_t * restrict bitmap, uint64_t bits) {
+  bitmap[0] = (int32_t)(uint32_t)bits;
+  bitmap[1] = (int32_t)(uint32_t)(bits >> 32);
+}
+
+//bits of the n_a valid outer elements
+static inline uint64_t valid_rows(int32_t n_a) {
+  return n_a >= 64 ? ~0ull : (1ull << n_a) - 1;
+}
+
+//n_a / n_b are the valid elements of the two tiles, 64 except for the tail
+//tile of a relation whose size is not a multiple of 64; the rest of the
+//tile is padding and never matches
+#ifdef AIE_HOST_EMULATION
+//scalar model of the vector kernel below for the host emulation
+void odd_even_semi(int32_t * restrict input, int32_t * restrict input1, const int32_t n_a, const int32_t n_b, int32_t * restrict bitmap) {
+   uint64_t bits = load_bits(bitmap);
+   const uint64_t all = valid_rows(n_a);
+   if ((bits & all) == all)
+      return;
+   for (int a = 0; a < n_a; a++) {
+      if ((bits >> a) & 1)
+        continue;
+      for (int j = 0; j < n_b; j++) {
+        if (input[a] == input1[j]) {
+          bits |= 1ull << a;
+          break;
+        }
+      }
+   }
+   store_bits(bitmap, bits);
+}
+#else
+//lanes of the j-th 16 element vector of B that hold valid elements
+static inline aie::mask<16> valid_lanes(int32_t n_b, int j) {
+  int32_t n = n_b - 16 * j;
+  uint32_t bits = n >= 16 ? 0xFFFFu : (n <= 0 ? 0u : (1u << n) - 1);
+  return aie::mask<16>::from_uint32(bits);
+}
+
+//ORs the aie::eq masks of one inner tile into the bit of every outer element,
+//the bitmap is carried over all inner tiles of the outer tile
+void odd_even_semi(int32_t * restrict input, int32_t * restrict input1, const int32_t n_a, const int32_t n_b, int32_t * restrict bitmap) {
+  //event0();
+  uint64_t bits = load_bits(bitmap);
+  const uint64_t all = valid_rows(n_a);
+  //every outer element already has a partner, the remaining inner tiles are
+  //only acquired and released
+  if ((bits & all) == all)
+    return;
+
+  aie::vector<int32_t, 16> B0 = aie::load_v<16>(input1);
+  aie::vector<int32_t, 16> B1 = aie::load_v<16>(input1 + 16);
+  aie::vector<int32_t, 16> B2 = aie::load_v<16>(input1 + 32);
+  aie::vector<int32_t, 16> B3 = aie::load_v<16>(input1 + 48);
+  aie::mask<16> v0 = valid_lanes(n_b, 0);
+  aie::mask<16> v1 = valid_lanes(n_b, 1);
+  aie::mask<16> v2 = valid_lanes(n_b, 2);
+  aie::mask<16> v3 = valid_lanes(n_b, 3);
+
+  AIE_PREPARE_FOR_PIPELINING
+  for (int a = 0; a < n_a; a++) {
+    //elements that matched an earlier inner tile are not compared again
+    if ((bits >> a) & 1)
+      continue;
+    int32_t key = input[a];
+    auto mask = (aie::eq(B0, key) & v0) | (aie::eq(B1, key) & v1) |
+                (aie::eq(B2, key) & v2) | (aie::eq(B3, key) & v3);
+    bits |= (uint64_t)!mask.empty() << a;
+  }
+  store_bits(bitmap, bits);
+  //event1();
+}
+#endif
+
+//end of an outer tile: writes the bits of the n_a valid outer elements to
+//out, inverted for the anti join, counts them into selected and clears the
+//bitmap for the next outer tile
+void bitmap_flush(int32_t * restrict bitmap, int32_t * restrict out, const int32_t n_a, const int32_t anti, int32_t * restrict selected) {
+  uint64_t bits = load_bits(bitmap);
+  if (anti)
+    bits = ~bits;
+  bits &= valid_rows(n_a);
+  store_bits(out, bits);
+  *selected += __builtin_popcountll(bits);
+  store_bits(bitmap, 0);
+}
+
+} // extern "C"
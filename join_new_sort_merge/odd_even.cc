@@ -0,0 +1,162 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <type_traits>
+#include <algorithm>
+#ifndef AIE_HOST_EMULATION
+#include <aie_api/aie.hpp>
+#include <aie_api/utils.hpp>
+#endif
+#include "aie_kernel_utils.h"
+#include "aie_objectfifo.h"
+
+
+
+
+
+extern "C" {
+
+
+void writeout(
+            int32_t * restrict in_buf0, int32_t * restrict in_buf1,
+            int32_t * restrict in_of_numer0, int32_t * in_of_numer1,
+            int32_t * restrict out_buf0,int32_t * restrict out_buf1,
+            int64_t in_acq_lock,int64_t in_rel_lock,
+            int64_t in_of_numer_acq_lock,int64_t in_of_numer_rel_lock,
+            int64_t out_acq_lock, int64_t out_rel_lock,
+            int32_t * restrict elems_produced,
+            const int32_t iters_outer,
+            const int32_t iters_inner
+            ) {
+            *elems_produced =0;
+
+            objectfifo_t of_in = {(int32_t)in_acq_lock, (int32_t)in_rel_lock, -1, 1, 2,
+                                {in_buf0, in_buf1}};
+            objectfifo_t of_in_of_numer = {(int32_t)in_of_numer_acq_lock, (int32_t)in_of_numer_rel_lock, -1, 1, 2,
+                                {in_of_numer0, in_of_numer1}};
+
+            objectfifo_t of_out = {(int32_t)out_acq_lock, (int32_t)out_rel_lock, -1, 1, 2,
+                                 {out_buf0, out_buf1}};
+
+
+            objectfifo_acquire(&of_out);
+            int32_t *out = (int32_t *)objectfifo_get_buffer(&of_out, 0);
+            int freeOutBuf = 4096;
+            int outCount = 0;
+            int count_out_ac = 1;
+
+            //262144
+            //for (int i = 0; i < 65536; i++) {
+            //todo why are two loops not possible
+            for (int64_t i = 0; i < ((int64_t)iters_outer)*(int64_t)iters_inner; i++) {
+
+            //for (int i = 0; i < 512; i++) {
+            //for (int z = 0; z < 512; z++) {
+                objectfifo_acquire(&of_in);
+                int32_t *input = (int32_t *)objectfifo_get_buffer(&of_in, i);
+
+                objectfifo_acquire(&of_in_of_numer);
+                int32_t *numer_el = (int32_t *)objectfifo_get_buffer(&of_in_of_numer, i);
+                //event0();
+                *elems_produced += *numer_el;
+
+                auto to_copy = std::min(*numer_el,freeOutBuf);
+
+
+
+              for (int j = 0; j < to_copy; j += 1) // Nx samples per loop
+              {
+                out[j+outCount] = input[j];
+              }
+              freeOutBuf = freeOutBuf - to_copy;
+              outCount = outCount + to_copy;
+
+              if(freeOutBuf == 0){
+
+                objectfifo_release(&of_out);
+                objectfifo_acquire(&of_out);
+                out = (int32_t *)objectfifo_get_buffer(&of_out, count_out_ac);
+                count_out_ac ++;
+
+                freeOutBuf = 4096;
+                outCount =0;
+                for (int j = 0; j < ((*numer_el) - to_copy); j += 1) // Nx samples per loop
+                {
+                out[j] = input[j+to_copy];
+                }
+                freeOutBuf = freeOutBuf -((*numer_el) - to_copy);
+                outCount = outCount + ((*numer_el) - to_copy);
+              }
+                //event1();
+
+                objectfifo_release(&of_in_of_numer);
+                objectfifo_release(&of_in);
+
+            }//}
+            for (int j = outCount; j < 4096; j += 1){
+            out[j] = -1;
+            }
+            objectfifo_release(&of_out);
+
+         }
+
+
+
+
+
+//merge join of two sorted 64 element tiles, the host sorts both relations
+//and pairs up the tiles whose key ranges overlap (join_utils/merge_path.h).
+//Partial and unused tiles are padded with keys that sort last and never
+//match each other. Every match writes the key, in the order outer element
+//major, inner element minor.
+#ifdef AIE_HOST_EMULATION
+//scalar model of the vector kernel below for the host emulation
+void merge_join(int32_t * restrict input, int32_t * restrict input1,  int32_t * restrict value,int32_t * restrict elems_produced) {
+   int join_count = 0;
+   int j0 = 0;
+   for (int i = 0; i < 64; i++) {
+      while (j0 < 64 && input1[j0] < input[i])
+        j0++;
+      for (int j = j0; j < 64 && input1[j] == input[i]; j++) {
+        value[join_count] = input1[j];
+        join_count++;
+      }
+   }
+   *elems_produced = join_count;
+}
+#else
+void merge_join(int32_t * restrict input, int32_t * restrict input1,  int32_t * restrict value,int32_t * restrict elems_produced) {
+  //event0();
+   int join_count = 0;
+   int32_t *__restrict valuev = value;
+
+   aie::vector<int32_t, 16> B[4];
+   AIE_LOOP_UNROLL_FULL
+   for (int j = 0; j < 4; j++)
+      B[j] = aie::load_v<16>(input1 + 16 * j);
+   const int32_t b_last = input1[63];
+
+   //first vector of B that can still match, A is sorted so it only moves up
+   int jb = 0;
+   for (int a = 0; a < 64; a++) {
+      int32_t key = input[a];
+      if (key > b_last)
+        break;
+      while (jb < 4 && input1[16 * jb + 15] < key)
+        jb++;
+      //equal keys of a sorted vector are adjacent, the compacted matches are
+      //k copies of the key
+      for (int j = jb; j < 4 && input1[16 * j] <= key; j++) {
+        int k = aie::eq(B[j], key).count();
+        aie::store_unaligned_v(valuev, aie::broadcast<int32_t, 16>(key));
+        valuev += k;
+        join_count += k;
+      }
+   }
+
+ *elems_produced = join_count;
+//event1();
+}
+#endif
+
+} // extern "C"
@@ -11,6 +11,7 @@
 
 #include "cxxopts.hpp"
 #include "test_utils.h"
+#include "hash_join.h"
 
 #include "xrt/xrt_bo.h"
 #include "xrt/xrt_device.h"
@@ -361,18 +362,9 @@ std::uniform_int_distribution<DATATYPE> dist(1, 64);
         }
 
 
-        std::vector<DATATYPE> ref;
-        std::unordered_map<DATATYPE, size_t> map_ref;
-        map_ref.reserve(OUT_SIZE);
-        ref.reserve(OUT_SIZE);
         auto start = std::chrono::high_resolution_clock::now();
-        for (uint32_t i = 0; i < IN_SIZE; i++) {
-            for (uint32_t j = 0; j < IN_SIZE; j++) {
-            if(bufInA[i] == bufInB[j]){
-            ref.push_back(bufInA[i]);
-            }
-        }
-        }
+        join_utils::JoinResult<DATATYPE> ref =
+            join_utils::radix_hash_join(bufInA, IN_SIZE, bufInB, IN_SIZE);
          auto stop = std::chrono::high_resolution_clock::now();
          float cpu_time =
         std::chrono::duration_cast<std::chrono::microseconds>(stop - start)
@@ -382,16 +374,11 @@ std::uniform_int_distribution<DATATYPE> dist(1, 64);
               << std::endl;
           cpu_time_total += cpu_time;
 
-        for (uint32_t i = 0; i < IN_SIZE; i++) {
-            for (uint32_t j = 0; j < IN_SIZE; j++) {
-            if(bufInA[i] == bufInB[j]){
-            //ref.push_back(bufInA[i]);
-            map_ref[bufInA[i]] ++;
-            }else{
-                map_ref[-1]++;
-            }
-        }
-        }
+        std::unordered_map<DATATYPE, size_t> map_ref(ref.histogram.begin(),
+                                              ref.histogram.end());
+        //the kernel writes -1 for every non matching pair
+        if (ref.matches.size() < (size_t)IN_SIZE * IN_SIZE)
+          map_ref[-1] += IN_SIZE * IN_SIZE - ref.matches.size();
         /*std::cout << "\nref:" << std::endl;
         for (auto& re :map_ref) {
 
@@ -1,4 +1,7 @@
+#measured iterations per point for the percentiles, ./collect.sh 1 for a quick pass
+iters=${1:-100}
+rm -f bench_xchesscc.csv bench_xchesscc.json
 for elements in 64 128 256 512 1024 2048 4096 8192 16384
 do
-    make run_xchesscc hostElements=${elements}
+    make run_xchesscc benchIters=${iters} hostElements=${elements}
 done
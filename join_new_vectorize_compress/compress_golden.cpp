@@ -0,0 +1,54 @@
+//===- compress_golden.cpp --------------------------------------*- C++ -*-===//
+//
+// Golden test of the vector compaction in compress.h, built for the host
+// with -DAIE_HOST_EMULATION. Every one of the 2^16 masks is compacted and
+// compared with the scalar lane loop odd_even used before:
+//   comp_vec[k] = mask.test(t) ? A1[t] : -1; k += mask.test(t);
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <iostream>
+
+#include "../join_utils/compress.h"
+
+int main() {
+  int errors = 0;
+  compress_v16 in;
+  for (int t = 0; t < 16; t++)
+    in.e[t] = 1000 + t;
+
+  for (uint32_t m = 0; m < (1u << 16); m++) {
+    int32_t expected[16];
+    for (int t = 0; t < 16; t++)
+      expected[t] = -1;
+    int k = 0;
+    for (int t = 0; t < 16; t++) {
+      bool test = (m >> t) & 1;
+      expected[k] = test ? in.e[t] : -1;
+      k = k + test;
+    }
+
+    compress_plan p = compress_plan16(m);
+    compress_v16 got = compress16(in, p, -1);
+
+    bool equal = p.keep == (1u << k) - 1;
+    for (int t = 0; t < 16; t++)
+      equal = equal && got.e[t] == expected[t];
+    if (!equal) {
+      if (errors < 10)
+        std::cout << "mask 0x" << std::hex << m << std::dec
+                  << " differs, keep 0x" << std::hex << p.keep << std::dec
+                  << " expected k " << k << "\n";
+      errors++;
+    }
+  }
+
+  if (!errors) {
+    std::cout << std::endl << "PASS!" << std::endl << std::endl;
+    return 0;
+  }
+  std::cout << std::endl << errors << " mismatches." << std::endl << std::endl;
+  std::cout << std::endl << "fail." << std::endl << std::endl;
+  return 1;
+}
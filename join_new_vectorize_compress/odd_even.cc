@@ -5,6 +5,7 @@
 #include <aie_api/aie.hpp>
 #include <aie_api/utils.hpp>
 #include "aie_kernel_utils.h"
+#include "../join_utils/compress.h"
 
 extern "C" {
 
@@ -36,18 +37,10 @@ void odd_even(int32_t * restrict input, int32_t * restrict input1,  int32_t * re
             aie::vector<int32_t, 16> A1 = aie::load_v<16>(input1v);
             auto mask =  aie::eq(A1,A0[z]);
 
-
-            aie::vector<int32_t, 16> comp_vec = aie::broadcast(-1);
-            int k = 0;
-            AIE_LOOP_UNROLL_FULL
-            for (int t = 0; t < 16; ++t) {
-                /*if (mask.test(t)) {
-                    comp_vec[k] = A1[t];
-                    k++;
-                }*/
-                comp_vec[k] = mask.test(t) ? A1[t] : -1 ;
-                k = k + mask.test(t);
-            }
+            //matches packed to the front, -1 behind them (compress.h)
+            compress_plan plan = compress_plan16(mask.to_uint32());
+            aie::vector<int32_t, 16> comp_vec = compress16(A1, plan, -1);
+            int k = mask.count();
             aie::store_unaligned_v(valuev,comp_vec);
             //aie::store_v(valuev,comp_vec);
             //auto newvec = aie::select(-1,A1,mask);
@@ -59,9 +52,18 @@ void odd_even(int32_t * restrict input, int32_t * restrict input1,  int32_t * re
        inputv +=16;
 
 }
-//todo vectorize this
- for (auto vv = valuev; vv < value + 4096;vv++) {
-    *vv= -1;
+//-1 after the last match, whole vectors where at least 16 are left,
+//the last store may overlap the one before
+ int32_t *value_end = value + 4096;
+ if (value_end - valuev >= 16) {
+    aie::vector<int32_t, 16> fill = aie::broadcast<int32_t, 16>(-1);
+    for (auto vv = valuev; vv + 16 <= value_end; vv += 16)
+      aie::store_unaligned_v(vv, fill);
+    aie::store_unaligned_v(value_end - 16, fill);
+ } else {
+    for (auto vv = valuev; vv < value_end;vv++) {
+       *vv= -1;
+    }
  }
 
 
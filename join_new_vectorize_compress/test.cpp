@@ -11,6 +11,8 @@
 
 #include "cxxopts.hpp"
 #include "test_utils.h"
+#include "hash_join.h"
+#include "bench.h"
 
 #include "xrt/xrt_bo.h"
 #include "xrt/xrt_device.h"
@@ -102,6 +104,18 @@ int main(int argc, const char *argv[]) {
   options.add_option("","e","host_elements", "host elements (assumed to be 4 bytes)",
       cxxopts::value<int64_t>()->default_value("1024"),"host elements");
 
+  options.add_option("","","variant", "design name the benchmark record is tagged with",
+      cxxopts::value<std::string>()->default_value("join_new_vectorize_compress"),"variant");
+
+  options.add_option("","","compiler", "kernel compiler the benchmark record is tagged with (peano, xchesscc, cpu)",
+      cxxopts::value<std::string>()->default_value("unknown"),"compiler");
+
+  options.add_option("","","bench_csv", "CSV file the benchmark record is appended to, empty for none",
+      cxxopts::value<std::string>()->default_value("bench.csv"),"bench csv");
+
+  options.add_option("","","bench_json", "file the benchmark record is appended to as a JSON line, empty for none",
+      cxxopts::value<std::string>()->default_value(""),"bench json");
+
   cxxopts::ParseResult vm;
   test_utils::parse_options(argc, argv, options, vm);
   int verbosity = vm["verbosity"].as<int>();
@@ -220,6 +234,7 @@ int main(int argc, const char *argv[]) {
   // Execute the kernel and wait to finish
   int errors = 0;
   unsigned num_iter = n_iterations + n_warmup_iterations;
+  join_utils::Bench bench(n_warmup_iterations);
   float npu_time_total = 0;
   float npu_time_min = 9999999;
   float npu_time_max = 0;
@@ -338,6 +353,7 @@ std::uniform_int_distribution<DATATYPE> dist(1, 64);
       continue;
 
     npu_time_total += npu_time;
+    bench.add_npu(iter, npu_time);
     npu_time_min = (npu_time < npu_time_min) ? npu_time : npu_time_min;
     npu_time_max = (npu_time > npu_time_max) ? npu_time : npu_time_max;
 
@@ -361,19 +377,9 @@ std::uniform_int_distribution<DATATYPE> dist(1, 64);
         }
 
 
-        std::vector<DATATYPE> ref;
-        //std::unordered_map<DATATYPE, size_t> map_ref;
-        std::map<DATATYPE, size_t> map_ref;
-        //map_ref.reserve(OUT_SIZE);
-        ref.reserve(OUT_SIZE);
         auto start = std::chrono::high_resolution_clock::now();
-        for (uint32_t i = 0; i < IN_SIZE; i++) {
-            for (uint32_t j = 0; j < IN_SIZE; j++) {
-            if(bufInA[i] == bufInB[j]){
-            ref.push_back(bufInA[i]);
-            }
-        }
-        }
+        join_utils::JoinResult<DATATYPE> ref =
+            join_utils::radix_hash_join(bufInA, IN_SIZE, bufInB, IN_SIZE);
          auto stop = std::chrono::high_resolution_clock::now();
          float cpu_time =
         std::chrono::duration_cast<std::chrono::microseconds>(stop - start)
@@ -382,17 +388,13 @@ std::uniform_int_distribution<DATATYPE> dist(1, 64);
               << "CPU time: " << cpu_time << "us."
               << std::endl;
           cpu_time_total += cpu_time;
+          bench.add_cpu(iter, cpu_time);
 
-        for (uint32_t i = 0; i < IN_SIZE; i++) {
-            for (uint32_t j = 0; j < IN_SIZE; j++) {
-            if(bufInA[i] == bufInB[j]){
-            //ref.push_back(bufInA[i]);
-            map_ref[bufInA[i]] ++;
-            }else{
-                map_ref[-1]++;
-            }
-        }
-        }
+        std::map<DATATYPE, size_t> map_ref(ref.histogram.begin(),
+                                              ref.histogram.end());
+        //the kernel writes -1 for every non matching pair
+        if (ref.matches.size() < (size_t)IN_SIZE * IN_SIZE)
+          map_ref[-1] += IN_SIZE * IN_SIZE - ref.matches.size();
         /*std::cout << "\nref:" << std::endl;
         for (auto& re :map_ref) {
 
@@ -447,8 +449,24 @@ std::cout << std::endl
   // Print Pass/Fail result of our test
   if (!errors) {
     std::cout << std::endl << "PASS!" << std::endl << std::endl;
-    std::ofstream log("logfile.csv", std::ios_base::app | std::ios_base::out);
-    log << host_elements << ";" << npu_time_total / n_iterations << ";" << cpu_time_total / n_iterations << "\n";
+    join_utils::BenchRecord record;
+    record.variant = vm["variant"].as<std::string>();
+    record.compiler = vm["compiler"].as<std::string>();
+    record.backend = "xrt";
+    record.size_a = host_elements;
+    record.size_b = host_elements;
+    //keys are uniform in 1..64
+    record.selectivity = 1.0 / 64;
+    record.cores = 1;
+    record.results = (uint64_t)std::llround(record.selectivity * (double)host_elements * (double)host_elements);
+    record.bytes = (host_elements + host_elements + record.results) * sizeof(DATATYPE);
+    record.warmup = n_warmup_iterations;
+    record.npu = bench.npu();
+    record.cpu = bench.cpu();
+    join_utils::bench_print(std::cout, record);
+    if (!join_utils::bench_append_csv(vm["bench_csv"].as<std::string>(), record) ||
+        !join_utils::bench_append_json(vm["bench_json"].as<std::string>(), record))
+      std::cout << "could not write the benchmark record\n";
     return 0;
   } else {
     std::cout << std::endl
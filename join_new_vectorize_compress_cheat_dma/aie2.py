@@ -39,6 +39,16 @@ if len(sys.argv) > 3:
     else:
         eprint("[Info] sys.argv[3] (host_elements):{} is not a positive number falling back to host_elements = 1024".format(sys.argv[3]))
 
+#sizes of the outer (A) and inner (B) relation, host_elements is the size of A
+size_a = host_elements
+size_b = host_elements
+if len(sys.argv) > 4:
+    if sys.argv[4].isdigit():
+        size_b = int(sys.argv[4])
+        eprint("[INFO] size_b: {}".format(size_b))
+    else:
+        eprint("[Info] sys.argv[4] (size_b):{} is not a positive number falling back to size_b = host_elements".format(sys.argv[4]))
+
 
 
 def external_mem_to_core():
@@ -51,12 +61,23 @@ def external_mem_to_core():
 
 
 
-            tranfer_size_elemnts_in = host_elements
+            tile_ty_size_in = 64
+
+            #the host pads both relations to whole tiles, the last tile of
+            #each only has tail_a / tail_b valid elements
+            tiles_a = -(-size_a // tile_ty_size_in)
+            tiles_b = -(-size_b // tile_ty_size_in)
+            tail_a = size_a % tile_ty_size_in
+            tail_b = size_b % tile_ty_size_in
+
+            tranfer_size_elemnts_a = tiles_a * tile_ty_size_in
+            tranfer_size_elemnts_b = tiles_b * tile_ty_size_in
             #one GB
             tranfer_size_elemnts_out = (268435456)
 
 
-            eprint("[INFO] tranfer_size_elemnts_in: {}".format(tranfer_size_elemnts_in))
+            eprint("[INFO] tranfer_size_elemnts_a: {}".format(tranfer_size_elemnts_a))
+            eprint("[INFO] tranfer_size_elemnts_b: {}".format(tranfer_size_elemnts_b))
             eprint("[INFO] tranfer_size_elemnts_out: {}".format(tranfer_size_elemnts_out))
 
 
@@ -65,22 +86,19 @@ def external_mem_to_core():
 
             #elements = 4096
 
-            tile_ty_size_in = 64
             tile_ty_size_out = tile_ty_size_in * tile_ty_size_in
 
             eprint("[INFO] tile_ty_size_in: {}".format(tile_ty_size_in))
             eprint("[INFO] tile_ty_size_out: {}".format(tile_ty_size_out))
 
-            #todo fix for A B different sizes
-            iters_outer = host_elements // tile_ty_size_in
+            #full tiles, the tail tiles are extra calls after the loops
+            iters_outer = size_a // tile_ty_size_in
+            iters_inner = size_b // tile_ty_size_in
             #one relation needs to be pushed several times
-            transfers_inner = iters_outer
-
-            # todo fix for A B different sizes
-            iters_inner = host_elements // tile_ty_size_in
+            transfers_inner = tiles_a
 
-            eprint("[INFO] iters_outer: {}".format(iters_outer))
-            eprint("[INFO] iters_inner: {}".format(iters_inner))
+            eprint("[INFO] iters_outer: {} tail_a: {}".format(iters_outer, tail_a))
+            eprint("[INFO] iters_inner: {} tail_b: {}".format(iters_inner, tail_b))
 
             eprint("[INFO] transfers_inner: {}".format(transfers_inner))
 
@@ -90,15 +108,31 @@ def external_mem_to_core():
 
             #buffer_ty = np.ndarray[(elements,), np.dtype[np.int32]]
 
-            data_ty_in = np.ndarray[(tranfer_size_elemnts_in,), np.dtype[np.int32]]
+            data_ty_a = np.ndarray[(tranfer_size_elemnts_a,), np.dtype[np.int32]]
+            data_ty_b = np.ndarray[(tranfer_size_elemnts_b,), np.dtype[np.int32]]
             data_ty_out = np.ndarray[(tranfer_size_elemnts_out,), np.dtype[np.int32]]
 
             elms_produced_ty = np.ndarray[(1,), np.dtype[np.int32]]
+            #cycle counters of odd_even (core02) and writeout (core12), see
+            #the layout in odd_even.cc
+            stats_ty = np.ndarray[(8,), np.dtype[np.int32]]
+            writeout_stats_ty = np.ndarray[(9,), np.dtype[np.int32]]
+            data_ty_done = np.ndarray[(16,), np.dtype[np.int32]]
 
             # External, binary kernel definition
             odd_even = external_func(
                 "odd_even",
-                inputs=[tile_ty_in, tile_ty_in,tile_ty_out, np.int32,elms_produced_ty]
+                inputs=[tile_ty_in, tile_ty_in,tile_ty_out, np.int32, np.int32,elms_produced_ty,stats_ty]
+            )
+
+            stats_flush = external_func(
+                "stats_flush",
+                inputs=[stats_ty, stats_ty]
+            )
+
+            done_fill = external_func(
+                "done_fill",
+                inputs=[data_ty_done, elms_produced_ty, writeout_stats_ty, stats_ty]
             )
 
             passThroughLine = external_func(
@@ -124,6 +158,7 @@ def external_mem_to_core():
                     elms_produced_ty,
                     np.int32,#iters_outer
                     np.int32,#iters_inner
+                    writeout_stats_ty,
                 ]
             )
 
@@ -160,14 +195,41 @@ def external_mem_to_core():
             of_out = object_fifo("out1", MemTile11, ShimTile10, 2, tile_ty_out_mem)
             object_fifo_link(of_out1, of_out)
 
-            data_ty_done = np.ndarray[(16,), np.dtype[np.int32]]
             of_done = object_fifo("outdone", ComputeTile12, ShimTile10, 2, data_ty_done)
+            #odd_even counters of one run, core02 -> core12 once at the end
+            of_stats = object_fifo("core_stats", ComputeTile02, ComputeTile12, 1, stats_ty)
 
 
 
 
             # Set up compute tiles
             # Compute tile
+            #one outer tile of A against all of B, the tail tile of B is
+            #a statically generated extra call
+            def join_outer_tile(elem_in, n_a):
+                def inner_tile(n_b):
+                    elem_inner = of_in_inner.acquire(ObjectFifoPort.Consume, 1)
+                    out = trans.acquire(ObjectFifoPort.Produce, 1)
+                    numer_el = of_numer_els.acquire(ObjectFifoPort.Produce, 1)
+
+                    call(odd_even, [elem_in, elem_inner, out, n_a, n_b, numer_el, odd_even_stats])
+
+                    of_numer_els.release(ObjectFifoPort.Produce, 1)
+                    trans.release(ObjectFifoPort.Produce, 1)
+                    of_in_inner.release(ObjectFifoPort.Consume, 1)
+
+                for _ in range_(iters_inner):
+                    inner_tile(tile_ty_size_in)
+                if tail_b > 0:
+                    inner_tile(tail_b)
+
+            odd_even_stats = aie.buffer(
+                tile=ComputeTile02,
+                datatype=stats_ty,
+                name=f"odd_even_stats",
+                initial_value=np.zeros(8, dtype=np.int32)
+            )
+
             @core(ComputeTile02, "odd_even.o",dynamic_objfifo_lowering=False)
             def core_body_02():
 
@@ -175,21 +237,18 @@ def external_mem_to_core():
                     #for _ in range_(iters):
                     for _ in range_(iters_outer):
                         elem_in = of_in1.acquire(ObjectFifoPort.Consume, 1)
+                        join_outer_tile(elem_in, tile_ty_size_in)
+                        of_in1.release(ObjectFifoPort.Consume, 1)
 
-                        for _ in range_(iters_inner):
-                            elem_inner = of_in_inner.acquire(ObjectFifoPort.Consume, 1)
-                            out = trans.acquire(ObjectFifoPort.Produce, 1)
-                            numer_el = of_numer_els.acquire(ObjectFifoPort.Produce, 1)
-
-                            call(odd_even, [elem_in, elem_inner, out, tile_ty_size_in,numer_el])
-
-                            of_numer_els.release(ObjectFifoPort.Produce, 1)
-                            trans.release(ObjectFifoPort.Produce, 1)
-                            of_in_inner.release(ObjectFifoPort.Consume, 1)
-
-
+                    if tail_a > 0:
+                        elem_in = of_in1.acquire(ObjectFifoPort.Consume, 1)
+                        join_outer_tile(elem_in, tail_a)
                         of_in1.release(ObjectFifoPort.Consume, 1)
 
+                    stats_out = of_stats.acquire(ObjectFifoPort.Produce, 1)
+                    call(stats_flush, [odd_even_stats, stats_out])
+                    of_stats.release(ObjectFifoPort.Produce, 1)
+
             ty_one_int = np.ndarray[(1,), np.dtype[np.int32]]
 
             elemt_coutn = aie.buffer(
@@ -199,6 +258,13 @@ def external_mem_to_core():
                 initial_value=np.array(0, dtype=np.int32)
             )
 
+            writeout_stats = aie.buffer(
+                tile=ComputeTile12,
+                datatype=writeout_stats_ty,
+                name=f"writeout_stats",
+                initial_value=np.zeros(9, dtype=np.int32)
+            )
+
             @core(ComputeTile12, "odd_even.o", dynamic_objfifo_lowering=False)
             def core_body_12():
                 elemt_coutn[0] = 0
@@ -223,8 +289,9 @@ def external_mem_to_core():
                              numer_els_acq, numer_els_rel,
                              out_acq,out_rel,
                              elemt_coutn,
-                             iters_outer,
-                             iters_inner
+                             tiles_a,
+                             tiles_b,
+                             writeout_stats
                              )
 
                     # elemt_coutn[0] = 0
@@ -240,9 +307,10 @@ def external_mem_to_core():
                     #     trans.release(ObjectFifoPort.Consume, 1)
 
                     elem_done = of_done.acquire(ObjectFifoPort.Produce, 1)
-                    for i in range_(16):
-                        elem_done[i] = 77
-                    elem_done[0] =  elemt_coutn[0]
+                    odd_even_counters = of_stats.acquire(ObjectFifoPort.Consume, 1)
+                    #join count and the cycle counters of both cores
+                    done_fill(elem_done, elemt_coutn, writeout_stats, odd_even_counters)
+                    of_stats.release(ObjectFifoPort.Consume, 1)
                     of_done.release(ObjectFifoPort.Produce, 1)
 
 
@@ -260,7 +328,7 @@ def external_mem_to_core():
 
 
 
-            @runtime_sequence(data_ty_in, data_ty_in,data_ty_out,data_ty_done)
+            @runtime_sequence(data_ty_a, data_ty_b,data_ty_out,data_ty_done)
             def sequence(inTensor,innerinTensor,outOddTensor,doneTensor):
 
                 if trace_size > 0:
@@ -274,7 +342,7 @@ def external_mem_to_core():
 
 
 
-                in_task = shim_dma_single_bd_task(of_in_sh, inTensor, offset= 0 ,sizes=[1, 1, 1, tranfer_size_elemnts_in],issue_token=False)
+                in_task = shim_dma_single_bd_task(of_in_sh, inTensor, offset= 0 ,sizes=[1, 1, 1, tranfer_size_elemnts_a],issue_token=False)
                 out_task = shim_dma_single_bd_task(
                     of_out, outOddTensor, offset=0, sizes=[1, 1, 1, tranfer_size_elemnts_out]
                 )
@@ -287,7 +355,7 @@ def external_mem_to_core():
 
                 for i in range(transfers_inner):
                     inner_in_task1 = shim_dma_single_bd_task(of_in_inner_sh, innerinTensor, offset=0,
-                                                      sizes=[1, 1, 1, tranfer_size_elemnts_in], issue_token=True)
+                                                      sizes=[1, 1, 1, tranfer_size_elemnts_b], issue_token=True)
 
                     dma_start_task(inner_in_task1)
                     dma_await_task(inner_in_task1)
@@ -2,10 +2,54 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <type_traits>
+#include <algorithm>
+#ifndef AIE_HOST_EMULATION
 #include <aie_api/aie.hpp>
 #include <aie_api/utils.hpp>
+#endif
 #include "aie_kernel_utils.h"
 #include "aie_objectfifo.h"
+#ifdef AIE_HOST_EMULATION
+#include <chrono>
+//trace markers only exist on the core
+static inline void event0() {}
+static inline void event1() {}
+#endif
+
+//core cycle counter, nanoseconds of the host clock in the host emulation
+static inline uint64_t core_cycles() {
+#ifdef AIE_HOST_EMULATION
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#else
+  return aie::tile::current().cycles();
+#endif
+}
+
+//64 bit counters are kept as (low, high) word pairs in the int32 buffers
+static inline uint64_t stats_get(const int32_t *s, int idx) {
+  return (uint64_t)(uint32_t)s[idx] | ((uint64_t)(uint32_t)s[idx + 1] << 32);
+}
+
+static inline void stats_set(int32_t *s, int idx, uint64_t v) {
+  s[idx] = (int32_t)(uint32_t)v;
+  s[idx + 1] = (int32_t)(uint32_t)(v >> 32);
+}
+
+//odd_even stats buffer of core02 (8 words):
+//[0,1] cycles inside odd_even, [2,3] cycles between two calls (lock waits
+//of the core body), [4,5] cycle stamp of the last return, 0 before the
+//first call of a run, [6] calls
+//writeout stats buffer of core12 (9 words):
+//[0,1] cycles waiting for the trans / of_numer_els input,
+//[2,3] cycles copying (compaction), [4,5] cycles waiting for an out buffer,
+//[6,7] cycles of the whole writeout call, [8] out buffers written
+//outdone as seen by the host, see join_utils/core_stats.h:
+//[0] join count, [1] odd_even calls, [2,3] odd_even compare cycles,
+//[4,5] odd_even wait cycles, [6..13] the writeout stats, [14] out buffers,
+//[15] CORE_STATS_TAG
+#define CORE_STATS_TAG 0x53540001
 
 
 
@@ -23,9 +67,12 @@ void writeout(
             int64_t out_acq_lock, int64_t out_rel_lock,
             int32_t * restrict elems_produced,
             const int32_t iters_outer,
-            const int32_t iters_inner
+            const int32_t iters_inner,
+            int32_t * restrict stats
             ) {
             *elems_produced =0;
+            uint64_t call_start = core_cycles();
+            uint64_t in_wait = 0, out_wait = 0, t0;
 
             objectfifo_t of_in = {(int32_t)in_acq_lock, (int32_t)in_rel_lock, -1, 1, 2,
                                 {in_buf0, in_buf1}};
@@ -36,7 +83,9 @@ void writeout(
                                  {out_buf0, out_buf1}};
 
 
+            t0 = core_cycles();
             objectfifo_acquire(&of_out);
+            out_wait += core_cycles() - t0;
             int32_t *out = (int32_t *)objectfifo_get_buffer(&of_out, 0);
             int freeOutBuf = 4096;
             int outCount = 0;
@@ -49,12 +98,15 @@ void writeout(
 
             //for (int i = 0; i < 512; i++) {
             //for (int z = 0; z < 512; z++) {
+                t0 = core_cycles();
                 objectfifo_acquire(&of_in);
                 int32_t *input = (int32_t *)objectfifo_get_buffer(&of_in, i);
 
                 objectfifo_acquire(&of_in_of_numer);
+                in_wait += core_cycles() - t0;
                 int32_t *numer_el = (int32_t *)objectfifo_get_buffer(&of_in_of_numer, i);
-                //event0();
+                //one trace invocation per input tile (trace_decoder.h)
+                event0();
                 *elems_produced += *numer_el;
 
                 auto to_copy = std::min(*numer_el,freeOutBuf);
@@ -71,7 +123,9 @@ void writeout(
               if(freeOutBuf == 0){
 
                 objectfifo_release(&of_out);
+                t0 = core_cycles();
                 objectfifo_acquire(&of_out);
+                out_wait += core_cycles() - t0;
                 out = (int32_t *)objectfifo_get_buffer(&of_out, count_out_ac);
                 count_out_ac ++;
 
@@ -84,7 +138,7 @@ void writeout(
                 freeOutBuf = freeOutBuf -((*numer_el) - to_copy);
                 outCount = outCount + ((*numer_el) - to_copy);
               }
-                //event1();
+                event1();
 
                 objectfifo_release(&of_in_of_numer);
                 objectfifo_release(&of_in);
@@ -95,13 +149,102 @@ void writeout(
             }
             objectfifo_release(&of_out);
 
+            //everything that is not waiting is the compaction copy
+            uint64_t total = core_cycles() - call_start;
+            stats_set(stats, 0, in_wait);
+            stats_set(stats, 2, total - in_wait - out_wait);
+            stats_set(stats, 4, out_wait);
+            stats_set(stats, 6, total);
+            stats[8] = count_out_ac;
+
          }
 
+//core02, end of a run: hands the odd_even stats to core12 over the stats
+//fifo and starts the next run from zero
+void stats_flush(int32_t * restrict stats, int32_t * restrict out) {
+  for (int i = 0; i < 8; i++) {
+    out[i] = stats[i];
+    stats[i] = 0;
+  }
+}
+
+//core12, end of a run: the 16 words of outdone
+void done_fill(int32_t * restrict done, int32_t * restrict join_cnt,
+               int32_t * restrict writeout_stats, int32_t * restrict odd_even_stats) {
+  done[0] = *join_cnt;
+  done[1] = odd_even_stats[6];
+  for (int i = 0; i < 4; i++)
+    done[2 + i] = odd_even_stats[i];
+  for (int i = 0; i < 8; i++)
+    done[6 + i] = writeout_stats[i];
+  done[14] = writeout_stats[8];
+  done[15] = CORE_STATS_TAG;
+}
+
+
+
+
+
+//n_a / n_b are the valid elements of the two tiles, 64 except for the tail
+//tile of a relation whose size is not a multiple of 64; the rest of the
+//tile is padding and never matches
+#ifdef AIE_HOST_EMULATION
+//scalar model of the vector kernel below for the host emulation,
+//writes the matches in the same order (outer element major, inner element minor)
+static inline void odd_even_tile(int32_t * restrict input, int32_t * restrict input1,  int32_t * restrict value,const int32_t n_a,const int32_t n_b,int32_t * restrict elems_produced) {
+   int join_count = 0;
+   for (int i = 0; i < n_a; i++) {
+      for (int j = 0; j < n_b; j++) {
+        if (input[i] == input1[j]) {
+          value[join_count] = input1[j];
+          join_count++;
+        }
+      }
+   }
+   *elems_produced = join_count;
+}
+#else
+//lanes of the j-th 16 element vector of B that hold valid elements
+static inline aie::mask<16> valid_lanes(int32_t n_b, int j) {
+  int32_t n = n_b - 16 * j;
+  uint32_t bits = n >= 16 ? 0xFFFFu : (n <= 0 ? 0u : (1u << n) - 1);
+  return aie::mask<16>::from_uint32(bits);
+}
 
+//tail tile, same output order as the full tile below
+static inline void odd_even_masked(int32_t * restrict input, int32_t * restrict input1,  int32_t * restrict value,const int32_t n_a,const int32_t n_b,int32_t * restrict elems_produced) {
+   int join_count = 0;
+   int32_t *__restrict valuev = value;
 
+   for (int a = 0; a < n_a; a++) {
+      int32_t key = input[a];
+      int32_t *__restrict input1v = input1;
+      AIE_LOOP_UNROLL_FULL
+      for (int j = 0; j < 4; j++) {
+            aie::vector<int32_t, 16> A1 = aie::load_v<16>(input1v);
+            auto mask = aie::eq(A1,key) & valid_lanes(n_b, j);
 
+            aie::vector<int32_t, 16> comp_vec = aie::broadcast(-1);
+            int k = 0;
+            AIE_LOOP_UNROLL_FULL
+            for (int t = 0; t < 16; ++t) {
+                comp_vec[k] = mask.test(t) ? A1[t] : -1 ;
+                k = k + mask.test(t);
+            }
+            aie::store_unaligned_v(valuev,comp_vec);
+            valuev +=k;
+            join_count +=k;
+            input1v += 16;
+      }
+   }
+   *elems_produced = join_count;
+}
 
-void odd_even(int32_t * restrict input, int32_t * restrict input1,  int32_t * restrict value,const int32_t N,int32_t * restrict elems_produced) {
+static inline void odd_even_tile(int32_t * restrict input, int32_t * restrict input1,  int32_t * restrict value,const int32_t n_a,const int32_t n_b,int32_t * restrict elems_produced) {
+  if (n_a != 64 || n_b != 64) {
+    odd_even_masked(input, input1, value, n_a, n_b, elems_produced);
+    return;
+  }
   //event0();
 
 
@@ -165,5 +308,23 @@ void odd_even(int32_t * restrict input, int32_t * restrict input1,  int32_t * re
 
 //event1();
 }
+#endif
+
+//stats is the odd_even stats buffer of core02, two cycle reads per call
+void odd_even(int32_t * restrict input, int32_t * restrict input1,  int32_t * restrict value,const int32_t n_a,const int32_t n_b,int32_t * restrict elems_produced, int32_t * restrict stats) {
+  uint64_t entry = core_cycles();
+  uint64_t last = stats_get(stats, 4);
+  if (last != 0)
+    stats_set(stats, 2, stats_get(stats, 2) + (entry - last));
+
+  event0();
+  odd_even_tile(input, input1, value, n_a, n_b, elems_produced);
+  event1();
+
+  uint64_t leave = core_cycles();
+  stats_set(stats, 0, stats_get(stats, 0) + (leave - entry));
+  stats_set(stats, 4, leave);
+  stats[6]++;
+}
 
 } // extern "C"
@@ -4,22 +4,27 @@
 #include <sstream>
 #include <string>
 #include <vector>
+#include <mutex>
 #include <set>
 #include<unordered_map>
 
-#include <random>
 
 #include "cxxopts.hpp"
 #include "test_utils.h"
-
-#include "xrt/xrt_bo.h"
-#include "xrt/xrt_device.h"
-#include "xrt/xrt_hw_context.h"
-#include "xrt/xrt_kernel.h"
-
-
-
+#include "hash_join.h"
+#include "join_verify.h"
+#include "pipeline.h"
+#include "bench.h"
+#include "datagen.h"
+#include "core_stats.h"
+#include "trace_decoder.h"
+#include "exec_backend.h"
+#include "host_emu.h"
+
+#ifndef JOIN_NO_XRT
+#include "xrt_backend.h"
 #include "xrt/xrt_graph.h"
+#endif
 
 
 #ifndef DATATYPES_USING_DEFINED
@@ -28,53 +33,6 @@ using DATATYPE = std::int32_t;
 #endif
 
 
-void my_init_xrt_load_kernel(xrt::device &device, xrt::kernel &kernel,
-                                      int verbosity, std::string xclbinFileName,
-                                      std::string kernelNameInXclbin) {
-  // Get a device handle
-  unsigned int device_index = 0;
-  device = xrt::device(device_index);
-
-  // Load the xclbin
-  if (verbosity >= 1)
-    std::cout << "Loading xclbin: " << xclbinFileName << "\n";
-  auto xclbin = xrt::xclbin(xclbinFileName);
-
-  if (verbosity >= 1)
-    std::cout << "Kernel opcode: " << kernelNameInXclbin << "\n";
-
-  // Get the kernel from the xclbin
-  auto xkernels = xclbin.get_kernels();
-  auto xkernel =
-      *std::find_if(xkernels.begin(), xkernels.end(),
-                    [kernelNameInXclbin, verbosity](xrt::xclbin::kernel &k) {
-                      auto name = k.get_name();
-                      if (verbosity >= 1) {
-                        std::cout << "Name: " << name << std::endl;
-                      }
-                      return name.rfind(kernelNameInXclbin, 0) == 0;
-                    });
-  auto kernelName = xkernel.get_name();
-  // Register xclbin
-  if (verbosity >= 1)
-    std::cout << "Registering xclbin: " << xclbinFileName << "\n";
-
-  device.register_xclbin(xclbin);
-
-  // Get a hardware context
-  if (verbosity >= 1)
-    std::cout << "Getting hardware context.\n";
-   //does set exclusive help?
-  xrt::hw_context context(device, xclbin.get_uuid(), xrt::hw_context::access_mode::exclusive);
-
-  // Get a kernel handle
-  if (verbosity >= 1)
-    std::cout << "Getting handle to kernel:" << kernelName << "\n";
-  kernel = xrt::kernel(context, kernelName);
-
-  return;
-}
-
 uint32_t getParity(uint32_t n) {
   int count = 0;
   while (n > 0) {
@@ -102,9 +60,51 @@ int main(int argc, const char *argv[]) {
   options.add_option("","e","host_elements", "host elements (assumed to be 4 bytes)",
       cxxopts::value<int64_t>()->default_value("1024"),"host elements");
 
-  options.add_option("","d","dist", "distribution value ",
+  options.add_option("","","size_a", "elements of the outer relation A, 0 means host_elements, must match aie2.py",
+      cxxopts::value<int64_t>()->default_value("0"),"size a");
+
+  options.add_option("","","size_b", "elements of the inner relation B, 0 means host_elements, must match aie2.py",
+      cxxopts::value<int64_t>()->default_value("0"),"size b");
+
+  options.add_option("","d","dist", "key domain, keys are drawn from 1 .. dist (uniform, zipf, no_match), selectivity 1/dist by default",
       cxxopts::value<int32_t>()->default_value("100"),"distribution value");
 
+  options.add_option("","","key_dist", "key distribution: uniform, zipf, foreign_key, selectivity, all_equal, no_match",
+      cxxopts::value<std::string>()->default_value("uniform"),"key distribution");
+
+  options.add_option("","","selectivity", "join selectivity of --key_dist=selectivity, 0 means 1/dist",
+      cxxopts::value<double>()->default_value("0"),"selectivity");
+
+  options.add_option("","","zipf_s", "skew of --key_dist=zipf",
+      cxxopts::value<double>()->default_value("1.0"),"zipf exponent");
+
+  options.add_option("","","trace_decode", "decode the trace buffer in process and print per core invocation latencies and lock stalls",
+      cxxopts::value<bool>()->default_value("true"),"trace decode");
+
+  options.add_option("","","seed", "seed of the input generator",
+      cxxopts::value<uint64_t>()->default_value("12345"),"seed");
+
+  options.add_option("","b","backend", "execution backend: xrt or cpu (host emulation of the design)",
+      cxxopts::value<std::string>()->default_value("xrt"),"backend");
+
+  options.add_option("","s","sync_prefix", "skip the output pre-clear and sync back only the bufDone[0] prefix of the output",
+      cxxopts::value<bool>()->default_value("false"),"sync prefix");
+
+  options.add_option("","","pipeline_depth", "buffer sets in flight: 1 runs the iterations one after another, 2 or more queues the next run and prepares / verifies the neighbouring iterations on worker threads meanwhile",
+      cxxopts::value<unsigned>()->default_value("1"),"pipeline depth");
+
+  options.add_option("","","variant", "design name the benchmark record is tagged with",
+      cxxopts::value<std::string>()->default_value("join_new_vectorize_compress_cheat_dma"),"variant");
+
+  options.add_option("","","compiler", "kernel compiler the benchmark record is tagged with (peano, xchesscc, cpu)",
+      cxxopts::value<std::string>()->default_value("unknown"),"compiler");
+
+  options.add_option("","","bench_csv", "CSV file the benchmark record is appended to, empty for none",
+      cxxopts::value<std::string>()->default_value("bench.csv"),"bench csv");
+
+  options.add_option("","","bench_json", "file the benchmark record is appended to as a JSON line, empty for none",
+      cxxopts::value<std::string>()->default_value(""),"bench json");
+
   cxxopts::ParseResult vm;
   test_utils::parse_options(argc, argv, options, vm);
   int verbosity = vm["verbosity"].as<int>();
@@ -112,8 +112,17 @@ int main(int argc, const char *argv[]) {
   int n_warmup_iterations = vm["warmup"].as<int>();
   int trace_size = vm["trace_sz"].as<int>();
   std::string trace_file = vm["trace_file"].as<std::string>();
-
-  int upperdist = vm["dist"].as<int>();
+  bool trace_decode = vm["trace_decode"].as<bool>();
+
+  join_utils::DataGenConfig gen_config;
+  gen_config.domain = vm["dist"].as<int>();
+  gen_config.dist = join_utils::parse_key_dist(vm["key_dist"].as<std::string>());
+  gen_config.selectivity = vm["selectivity"].as<double>();
+  gen_config.zipf_s = vm["zipf_s"].as<double>();
+  gen_config.seed = vm["seed"].as<uint64_t>();
+  std::string backend_name = vm["backend"].as<std::string>();
+  bool sync_prefix = vm["sync_prefix"].as<bool>();
+  unsigned pipeline_depth = vm["pipeline_depth"].as<unsigned>();
 
   // Declaring design constants
   constexpr bool VERIFY = true;
@@ -123,98 +132,91 @@ int main(int argc, const char *argv[]) {
   //constexpr int64_t oneGBElements =  2048 * oneMBElements;
   int64_t host_elements = vm["host_elements"].as<int64_t>();
    std::cout << "host_elements: " << host_elements << "\n";
-  int64_t IN_SIZE = host_elements;
+  //A and B may differ and need not be multiples of 64, the buffers are
+  //padded to whole tiles and the kernel masks the tail tile
+  int64_t IN_SIZE_A = vm["size_a"].as<int64_t>() > 0 ? vm["size_a"].as<int64_t>() : host_elements;
+  int64_t IN_SIZE_B = vm["size_b"].as<int64_t>() > 0 ? vm["size_b"].as<int64_t>() : host_elements;
+  int64_t PADDED_SIZE_A = (IN_SIZE_A + 63) / 64 * 64;
+  int64_t PADDED_SIZE_B = (IN_SIZE_B + 63) / 64 * 64;
+  std::cout << "size_a: " << IN_SIZE_A << " size_b: " << IN_SIZE_B << "\n";
   //int64_t OUT_SIZE = IN_SIZE *IN_SIZE;
   //one GB
   int64_t OUT_SIZE =  268435456;
   bool enable_ctrl_pkts = false;
 
 
-  // Load instruction sequence
-  std::vector<uint32_t> instr_v =
-      test_utils::load_instr_binary(vm["instr"].as<std::string>());
+  std::unique_ptr<join_utils::ExecBackend> backend;
+  if (backend_name == "cpu") {
+    //same tiling as aie2.py, the cores run as host threads. The host
+    //emulation has one lock table, so queued runs execute one by one
+    auto emu_m = std::make_shared<std::mutex>();
+    backend = std::make_unique<join_utils::CpuBackend>(
+        [emu_m, IN_SIZE_A, IN_SIZE_B, OUT_SIZE](const std::vector<join_utils::Buffer *> &args) {
+          std::lock_guard<std::mutex> lk(*emu_m);
+          HostEmuStats stats;
+          bool ok = run_join_design_on_host(
+              args[0]->map<DATATYPE>(), IN_SIZE_A, args[1]->map<DATATYPE>(),
+              IN_SIZE_B, args[2]->map<DATATYPE>(), OUT_SIZE,
+              args[3]->map<uint32_t>(), &stats);
+          if (!ok)
+            std::cout << "host emulation failed: " << stats.error << "\n";
+          return ok;
+        });
+  } else {
+#ifndef JOIN_NO_XRT
+    // Load instruction sequence
+    std::vector<uint32_t> instr_v =
+        test_utils::load_instr_binary(vm["instr"].as<std::string>());
+
+    if (verbosity >= 1)
+      std::cout << "Sequence instr count: " << instr_v.size() << "\n";
+
+    // Start the XRT context and load the kernel
+    backend = std::make_unique<join_utils::XrtBackend>(
+        verbosity, vm["xclbin"].as<std::string>(),
+        vm["kernel"].as<std::string>(), instr_v);
+#else
+    std::cout << "built without XRT, only --backend=cpu is available\n";
+    return 1;
+#endif
+  }
+  std::cout << "backend: " << backend->name() << "\n";
 
-  if (verbosity >= 1)
-    std::cout << "Sequence instr count: " << instr_v.size() << "\n";
-
-  // Start the XRT context and load the kernel
-  xrt::device device;
-  xrt::kernel kernel;
-
-  /*test_utils::init_xrt_load_kernel(device, kernel, verbosity,
-                                   vm["xclbin"].as<std::string>(),
-                                   vm["kernel"].as<std::string>());*/
-
-  my_init_xrt_load_kernel(device, kernel, verbosity,
-                                   vm["xclbin"].as<std::string>(),
-                                   vm["kernel"].as<std::string>());
-
-
-  // set up the buffer objects
-  auto bo_instr = xrt::bo(device, instr_v.size() * sizeof(int),
-                          XCL_BO_FLAGS_CACHEABLE, kernel.group_id(1));
-  auto bo_inA = xrt::bo(device, IN_SIZE * sizeof(DATATYPE),
-                        XRT_BO_FLAGS_HOST_ONLY, kernel.group_id(3));
-
-  auto bo_inB = xrt::bo(device, OUT_SIZE * sizeof(DATATYPE),
-                         XRT_BO_FLAGS_HOST_ONLY, kernel.group_id(4));
-  auto bo_outC = xrt::bo(device, OUT_SIZE * sizeof(DATATYPE),
-                         XRT_BO_FLAGS_HOST_ONLY, kernel.group_id(5));
-
-  // If we enable control packets, then this is the input xrt buffer for that.
-  // Otherwise, this is a dummy placedholder buffer.
-    //todo why do we need this?
-   auto bo_done =
-      xrt::bo(device, 16 * sizeof(uint32_t), XRT_BO_FLAGS_HOST_ONLY, kernel.group_id(6));
-
-  // Workaround so we declare a really small trace buffer when one is not used
-  // Second workaround for driver issue. Allocate large trace buffer *4
-  // This includes the 8 bytes needed for control packet response.
-  //todo why 4* because of a segfault in the driver?
+  // set up the buffer objects, one set per pipeline slot (each with the 1GB
+  // output, mind the memory with deeper pipelines)
   int tmp_trace_size = (trace_size > 0) ? trace_size * 4  : 1;
-  auto bo_trace = xrt::bo(device, tmp_trace_size, XRT_BO_FLAGS_HOST_ONLY,
-                          kernel.group_id(7));
+  join_utils::RunPipeline pipeline(
+      *backend, pipeline_depth, [&](join_utils::ExecBackend &be) {
+        std::vector<std::unique_ptr<join_utils::Buffer>> bos;
+        bos.push_back(be.alloc(PADDED_SIZE_A * sizeof(DATATYPE), 3));
+        bos.push_back(be.alloc(PADDED_SIZE_B * sizeof(DATATYPE), 4));
+        bos.push_back(be.alloc(OUT_SIZE * sizeof(DATATYPE), 5));
+        // If we enable control packets, then this is the input xrt buffer for that.
+        // Otherwise, this is a dummy placedholder buffer.
+        //todo why do we need this?
+        bos.push_back(be.alloc(16 * sizeof(uint32_t), 6));
+        // Workaround so we declare a really small trace buffer when one is not used
+        // Second workaround for driver issue. Allocate large trace buffer *4
+        // This includes the 8 bytes needed for control packet response.
+        //todo why 4* because of a segfault in the driver?
+        bos.push_back(be.alloc(tmp_trace_size, 7));
+        return bos;
+      });
+  std::cout << "pipeline depth: " << pipeline.depth() << "\n";
 
   if (verbosity >= 1)
     std::cout << "Writing data into buffer objects.\n";
 
-  // Copy instruction stream to xrt buffer object
-  void *bufInstr = bo_instr.map<void *>();
-  memcpy(bufInstr, instr_v.data(), instr_v.size() * sizeof(int));
-
-  // Initialize buffer bo_inA
-
-  DATATYPE *bufInA = bo_inA.map<DATATYPE *>();
-  memset(bufInA, 0, IN_SIZE * sizeof(DATATYPE));
-
-   DATATYPE *bufInB = bo_inB.map<DATATYPE *>();
-  memset(bufInB, 0, IN_SIZE * sizeof(DATATYPE));
-
-  // Zero out buffer bo_outC
-  DATATYPE *bufOut = bo_outC.map<DATATYPE *>();
-  memset(bufOut, 0, OUT_SIZE * sizeof(DATATYPE));
-
-
-
-  char *bufTrace = bo_trace.map<char *>();
-
-
-
-  uint32_t *bufDone = bo_done.map<uint32_t *>();
-  memset(bufOut, 0, 16 * sizeof(uint32_t));
-
-
-  // sync host to device memories
-  bo_instr.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-  bo_inA.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-  bo_outC.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-  bo_inB.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-
-  bo_done.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-
-  if (trace_size > 0) {
-    bo_trace.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-
+  // the padding of the tail tiles stays zero, only the first IN_SIZE_A /
+  // IN_SIZE_B elements are rewritten every iteration
+  for (unsigned s = 0; s < pipeline.depth(); s++) {
+    std::vector<join_utils::Buffer *> bos = pipeline.buffers(s);
+    memset(bos[0]->map(), 0, PADDED_SIZE_A * sizeof(DATATYPE));
+    memset(bos[1]->map(), 0, PADDED_SIZE_B * sizeof(DATATYPE));
+    if (!sync_prefix) {
+      memset(bos[2]->map(), 0, OUT_SIZE * sizeof(DATATYPE));
+      bos[2]->sync(join_utils::SyncDir::ToDevice);
+    }
   }
 
 
@@ -222,240 +224,180 @@ int main(int argc, const char *argv[]) {
   // Execute the kernel and wait to finish
   int errors = 0;
   unsigned num_iter = n_iterations + n_warmup_iterations;
-  float npu_time_total = 0;
-  float npu_time_min = 9999999;
-  float npu_time_max = 0;
+  join_utils::Bench bench(n_warmup_iterations);
   float selectivi = 0;
+  uint64_t results = 0;
+  //cycle counters of the measured runs, summed
+  join_utils::CoreStats core_stats;
+  //packet trace of the measured runs, odd_even and writeout core
+  join_utils::TraceDecoder trace;
+  //finish of neighbouring iterations may run at the same time
+  std::mutex result_m;
 
-  float cpu_time_total = 0;
-
-
-  unsigned int opcode = 3;
-
-  /*auto run = xrt::run(kernel);
-  run.set_arg(0,opcode);
-  run.set_arg(1,bo_instr);
-  run.set_arg(2,instr_v.size());
 
-  run.set_arg(3,bo_inA);
-  run.set_arg(4,bo_outC);
-  run.set_arg(5,bo_outOdd);
-  //not sure about this one
-  run.set_arg(6,bo_ctrlpkts);
-  run.set_arg(7,bo_trace);*/
 
-  unsigned int seed = 12345;
+  //keys are generated by all host threads straight into the mapped inputs,
+  //a new set every iteration
+  join_utils::DataGen<DATATYPE> datagen(gen_config);
 
-// Create random engine with seed
-std::mt19937 rng(seed);
 
-upperdist = 300;
-// Define distribution (range 1–100)
-std::uniform_int_distribution<DATATYPE> dist(1, upperdist);
-
-
-  for (int iter = 0; iter < num_iter; iter++) {
-    //todo put back warmup iterrations
-     std::cout << "iter: " << iter <<"\n";
+  //inputs of iteration iter into the slot buffers, runs in iteration order
+  auto prepare = [&](size_t iter, const std::vector<join_utils::Buffer *> &bos) {
+      DATATYPE *bufInA = bos[0]->map<DATATYPE>();
+      DATATYPE *bufInB = bos[1]->map<DATATYPE>();
+      DATATYPE *bufOut = bos[2]->map<DATATYPE>();
+      uint32_t *bufDone = bos[3]->map<uint32_t>();
 
       if (verbosity >= 1) {
       std::cout << "Setting inputs and zero out out buffers ..." << std::endl;
     }
 
-       /*
-      for (int64_t i = 0; i < IN_SIZE; i++)
-        bufInA[i] =   iter +1; //plus one for first iteration
-
-       for (int64_t i = 0; i < IN_SIZE; i++)
-        bufInB[i] =   iter +1; //plus one for first iteration
-        */
-
-        for (int64_t i = 0; i < IN_SIZE; i++)
-        bufInA[i] =   dist(rng);
-
-       for (int64_t i = 0; i < IN_SIZE; i++)
-        bufInB[i] =   dist(rng);
-
-
-
-
+      datagen.fill(bufInA, IN_SIZE_A, bufInB, IN_SIZE_B, iter);
 
       // Zero out buffer bo_outC
-      memset(bufOut, -1, OUT_SIZE * sizeof(DATATYPE));
+      // not needed with sync_prefix, only the reported prefix is ever read
+      if (!sync_prefix)
+        memset(bufOut, -1, OUT_SIZE * sizeof(DATATYPE));
 
       memset(bufDone, 0, 16 * sizeof(uint32_t));
 
       if (trace_size > 0 ) {
           //zero out buffTrace each iteration???
-          memset(bufTrace,0,tmp_trace_size*sizeof(char));
-          bo_trace.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+          memset(bos[4]->map(),0,tmp_trace_size*sizeof(char));
+          bos[4]->sync(join_utils::SyncDir::ToDevice);
       }
-      //this should not be needed
-      //bo_instr.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-      bo_inA.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-      bo_inB.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-      bo_outC.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-      bo_done.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-
-
-    std::cout << "Running Kernel.\n";
-
-    auto start = std::chrono::high_resolution_clock::now();
-
-    auto run =
-        kernel(opcode, bo_instr, instr_v.size(), bo_inA,bo_inB, bo_outC, bo_done, bo_trace);
-
-
-        //xrt::autostart its {};
-        //its.iterations = 0;
-
-    //run.start();
-
-
-    ert_cmd_state r = run.wait();
-    //run.wait2();
-    auto stop = std::chrono::high_resolution_clock::now();
-     if(r != ERT_CMD_STATE_COMPLETED){
-        std::cout << "run.wait() did not return ERT_CMD_STATE_COMPLETED: " << r<<"\n";
-    }
+      bos[0]->sync(join_utils::SyncDir::ToDevice);
+      bos[1]->sync(join_utils::SyncDir::ToDevice);
+      if (!sync_prefix)
+        bos[2]->sync(join_utils::SyncDir::ToDevice);
+      bos[3]->sync(join_utils::SyncDir::ToDevice);
+  };
+
+  //syncs back and verifies iteration iter, the log lines of one iteration
+  //are printed together
+  auto finish = [&](size_t iter, const std::vector<join_utils::Buffer *> &bos,
+                    bool completed, double run_seconds) {
+    DATATYPE *bufInA = bos[0]->map<DATATYPE>();
+    DATATYPE *bufInB = bos[1]->map<DATATYPE>();
+    DATATYPE *bufOut = bos[2]->map<DATATYPE>();
+    uint32_t *bufDone = bos[3]->map<uint32_t>();
+    std::ostringstream msg;
+    msg << "iter: " << iter <<"\n";
 
     // Sync device to host memories
-    bo_outC.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
-
-    bo_done.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-
-
-    std::cout << "Print done:" << std::endl;
+    if (sync_prefix) {
+      // the done count tells how much of the 1GB output was written
+      bos[3]->sync(join_utils::SyncDir::FromDevice);
+      size_t out_bytes =
+          std::min<size_t>(bufDone[0], OUT_SIZE) * sizeof(DATATYPE);
+      if (out_bytes > 0)
+        bos[2]->sync(join_utils::SyncDir::FromDevice, out_bytes, 0);
+    } else {
+      bos[2]->sync(join_utils::SyncDir::FromDevice);
+
+      bos[3]->sync(join_utils::SyncDir::FromDevice);
+    }
 
+    msg << "Print done:" << std::endl;
     for (uint32_t i = 0; i < 16; i++) {
        int32_t test = bufDone[i];
-       std::cout << test << " ";
+       msg << test << " ";
     }
-    std::cout  << "\n";
-
-    if (trace_size > 0)
-      bo_trace.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+    msg  << "\n";
 
     //todo should tmp_trace_size be used here?
+    //an empty trace_file skips the text dump, the decoder reads the buffer
     if (trace_size > 0 ) {
-      test_utils::write_out_trace(((char *)bufTrace), trace_size,
-                                  trace_file);
+      bos[4]->sync(join_utils::SyncDir::FromDevice);
+      std::lock_guard<std::mutex> lk(result_m);
+      if (!trace_file.empty())
+        test_utils::write_out_trace(bos[4]->map<char>(), trace_size,
+                                    trace_file);
+      if (trace_decode && iter >= (size_t)n_warmup_iterations)
+        trace.decode(bos[4]->map<uint32_t>(), trace_size / sizeof(uint32_t));
     }
-    // Accumulate run times
-    /* Warmup iterations do not count towards average runtime. */
 
-    float npu_time =
-        std::chrono::duration_cast<std::chrono::microseconds>(stop - start)
-            .count();
-    std::cout << ""
+    float npu_time = run_seconds * 1e6;
+    msg << ""
               << "NPU time: " << npu_time << "us."
               << std::endl;
 
-  if (iter < n_warmup_iterations)
-      /* Warmup iterations do not count towards average runtime. */
-      continue;
-
-    npu_time_total += npu_time;
-    npu_time_min = (npu_time < npu_time_min) ? npu_time : npu_time_min;
-    npu_time_max = (npu_time > npu_time_max) ? npu_time : npu_time_max;
-
-
-
      if (PRINT_OUT_BUFFERS >= 1) {
-      std::cout << "Join:" << std::endl;
+      msg << "Join:" << std::endl;
 
       for (uint32_t i = 0; i < OUT_SIZE; i++) {
       int32_t test = bufOut[i];
-      std::cout << test << " ";
+      msg << test << " ";
     }
 
     }
 
-    // Compare out to golden
-
-    if(VERIFY){
+    bool ok = completed;
+    float cpu_time = 0;
+    double selectivity = 0;
+    if(VERIFY && iter >= (size_t)n_warmup_iterations){
         if (verbosity >= 1) {
-            std::cout << "Verifying results ..." << std::endl;
+            msg << "Verifying results ..." << std::endl;
         }
 
-
-        std::vector<DATATYPE> ref;
-        //std::unordered_map<DATATYPE, size_t> map_ref;
-        std::map<DATATYPE, size_t> map_ref;
-        //map_ref.reserve(OUT_SIZE);
-        ref.reserve(OUT_SIZE);
         auto start = std::chrono::high_resolution_clock::now();
-        for (uint32_t i = 0; i < IN_SIZE; i++) {
-            for (uint32_t j = 0; j < IN_SIZE; j++) {
-            if(bufInA[i] == bufInB[j]){
-            ref.push_back(bufInA[i]);
-            }
-        }
-        }
+        join_utils::JoinResult<DATATYPE> ref =
+            join_utils::radix_hash_join(bufInA, IN_SIZE_A, bufInB, IN_SIZE_B);
          auto stop = std::chrono::high_resolution_clock::now();
-         float cpu_time =
+         cpu_time =
         std::chrono::duration_cast<std::chrono::microseconds>(stop - start)
             .count();
-          std::cout << ""
+          msg << ""
               << "CPU time: " << cpu_time << "us."
               << std::endl;
-          cpu_time_total += cpu_time;
 
-         std::cout << ""
-              << "ref.size(): " << ref.size() << ""
+         msg << ""
+              << "ref.size(): " << ref.matches.size() << ""
               << std::endl;
-         std::cout << ""
-              << "selectivity: " << (double)ref.size() / (host_elements*host_elements) << ""
+        selectivity = (double)ref.matches.size() / (IN_SIZE_A*IN_SIZE_B);
+         msg << ""
+              << "selectivity: " << selectivity << ""
               << std::endl;
-        selectivi = (double)ref.size() / (host_elements*host_elements);
-        for (uint32_t i = 0; i < IN_SIZE; i++) {
-            for (uint32_t j = 0; j < IN_SIZE; j++) {
-            if(bufInA[i] == bufInB[j]){
-            //ref.push_back(bufInA[i]);
-            map_ref[bufInA[i]] ++;
-            }else{
-                //map_ref[-1]++;
-            }
-        }
-        }
-        /*std::cout << "\nref:" << std::endl;
-        for (auto& re :map_ref) {
-
-            std::cout << re.first << "  "<< re.second << "\n";
-        }*/
-
-        //std::unordered_map<DATATYPE, size_t> result;
-        std::map<DATATYPE, size_t> result;
 
-        //for (uint32_t i = 0; i < bufDone[0] OUT_SIZE; i++) {
-        for (uint32_t i = 0; i < OUT_SIZE; i++) {
-            if(bufOut[i] !=-1){
-            result[bufOut[i]] ++;
-            }
+        //only the prefix reported by the writeout core holds join results
+        size_t n_out = bufDone[0];
+        if (n_out > (size_t)OUT_SIZE) {
+            msg << "join count " << n_out << " exceeds OUT_SIZE " << OUT_SIZE << "\n";
+            n_out = OUT_SIZE;
         }
 
-        /*std::cout << "\nresult:" << std::endl;
-        for (auto& re :result) {
+        join_utils::VerifyResult<DATATYPE> check =
+            join_utils::verify_join_output(bufOut, n_out, ref.histogram);
 
-            std::cout << re.first << "  "<< re.second << "\n";
-        }*/
-
-        if(map_ref==result){
-            std::cout << "equal"<< "\n";
+        if(check.equal){
+            msg << "equal"<< "\n";
         }else{
-            std::cout << "not equal"<< "\n";
-            errors++;
+            msg << "not equal"<< "\n";
+            msg << "first differing key: " << check.key
+                      << " expected: " << check.expected
+                      << " got: " << check.got << "\n";
+            ok = false;
         }
-
-
-
-
     }
 
+    std::lock_guard<std::mutex> lk(result_m);
+    std::cout << msg.str();
+    /* Warmup iterations do not count towards average runtime. */
+    bench.add(iter, npu_time, cpu_time);
+    if (iter >= (size_t)n_warmup_iterations) {
+      selectivi = selectivity;
+      results = bufDone[0];
+      core_stats.add(join_utils::decode_core_stats(bufDone));
+    }
+    return ok;
+  };
 
-
-
-  }
+  std::cout << "Running Kernel.\n";
+  join_utils::PipelineStats pstats = pipeline.run(num_iter, prepare, finish);
+  errors += pstats.failed;
+  std::cout << "pipeline: " << num_iter << " iterations in "
+            << pstats.seconds * 1e6 << "us, "
+            << num_iter / pstats.seconds << " iterations/s\n";
 
   // print out profiling result
   std::cout << std::endl
@@ -463,17 +405,46 @@ std::uniform_int_distribution<DATATYPE> dist(1, upperdist);
           << " (warmup iterations: " << n_warmup_iterations << ")"
           << std::endl;
 
-  std::cout << std::endl
-            << "Avg NPU time: " << npu_time_total / n_iterations << "us."
-            << std::endl;
+  join_utils::BenchRecord record;
+  record.variant = vm["variant"].as<std::string>();
+  record.compiler = backend_name == "cpu" ? "cpu" : vm["compiler"].as<std::string>();
+  record.backend = backend->name();
+  record.size_a = IN_SIZE_A;
+  record.size_b = IN_SIZE_B;
+  record.selectivity = selectivi;
+  //join core and writeout core
+  record.cores = 2;
+  record.results = results;
+  record.bytes = (PADDED_SIZE_A + PADDED_SIZE_B + results + 16) * sizeof(DATATYPE);
+  record.warmup = n_warmup_iterations;
+  // the pipeline time covers the warmup iterations too, so it is divided
+  // by all of them
+  record.pipeline_depth = pipeline.depth();
+  record.pipeline_us = num_iter ? pstats.seconds * 1e6 / num_iter : 0;
+  record.npu = bench.npu();
+  //with depth > 1 the reference join competes with datagen and the other
+  //finish calls for the host threads, its times are not recorded
+  if (pipeline.depth() == 1)
+    record.cpu = bench.cpu();
 
-std::cout << std::endl
-            << "Avg CPU time: " << cpu_time_total / n_iterations << "us."
+  std::cout << std::endl
+            << "Avg NPU time: " << record.npu.mean << "us."
             << std::endl;
 
+  if (record.cpu.n > 0)
+    std::cout << std::endl
+              << "Avg CPU time: " << record.cpu.mean << "us."
+              << std::endl;
 
-    std::ofstream log("logfile.csv", std::ios_base::app | std::ios_base::out);
-    log << host_elements << ";" << npu_time_total / n_iterations << ";" << cpu_time_total / n_iterations << ";"<< selectivi<<"\n";
+  join_utils::bench_print(std::cout, record);
+  join_utils::print_core_stats(std::cout, core_stats, bench.measured());
+  if (trace_size > 0 && trace_decode) {
+    std::cout << "trace (" << bench.measured() << " runs):\n";
+    trace.print(std::cout, {"odd_even", "writeout"});
+  }
+  if (!join_utils::bench_append_csv(vm["bench_csv"].as<std::string>(), record) ||
+      !join_utils::bench_append_json(vm["bench_json"].as<std::string>(), record))
+    std::cout << "could not write the benchmark record\n";
 
   // Print Pass/Fail result of our test
   if (!errors) {
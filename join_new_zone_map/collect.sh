@@ -0,0 +1,8 @@
+#measured iterations per point for the percentiles, ./collect.sh 1 for a quick pass
+iters=${1:-100}
+rm -f bench_xchesscc.csv bench_xchesscc.json
+for elements in 1024 2048 4096 8192 16384 32768 65536 131072 262144
+do
+    make clean && make run_xchesscc benchIters=${iters} hostElements=${elements}
+    make run_xchesscc benchIters=${iters} hostElements=${elements} clustered=1
+done
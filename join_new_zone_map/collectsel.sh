@@ -0,0 +1,7 @@
+#measured iterations per point for the percentiles, ./collectsel.sh 1 for a quick pass
+iters=${1:-100}
+rm -f bench_xchesscc.csv bench_xchesscc.json
+for sels in 1 2 4 8 16 64 256 4096 16384
+do
+    make run_xchesscc benchIters=${iters} sel=${sels} keyDist=selectivity
+done
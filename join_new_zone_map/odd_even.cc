@@ -0,0 +1,270 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <type_traits>
+#include <algorithm>
+#ifndef AIE_HOST_EMULATION
+#include <aie_api/aie.hpp>
+#include <aie_api/utils.hpp>
+#endif
+#include "aie_kernel_utils.h"
+#include "aie_objectfifo.h"
+
+
+
+
+
+extern "C" {
+
+
+void writeout(
+            int32_t * restrict in_buf0, int32_t * restrict in_buf1,
+            int32_t * restrict in_of_numer0, int32_t * in_of_numer1,
+            int32_t * restrict out_buf0,int32_t * restrict out_buf1,
+            int64_t in_acq_lock,int64_t in_rel_lock,
+            int64_t in_of_numer_acq_lock,int64_t in_of_numer_rel_lock,
+            int64_t out_acq_lock, int64_t out_rel_lock,
+            int32_t * restrict elems_produced,
+            const int32_t iters_outer,
+            const int32_t iters_inner
+            ) {
+            *elems_produced =0;
+
+            objectfifo_t of_in = {(int32_t)in_acq_lock, (int32_t)in_rel_lock, -1, 1, 2,
+                                {in_buf0, in_buf1}};
+            objectfifo_t of_in_of_numer = {(int32_t)in_of_numer_acq_lock, (int32_t)in_of_numer_rel_lock, -1, 1, 2,
+                                {in_of_numer0, in_of_numer1}};
+
+            objectfifo_t of_out = {(int32_t)out_acq_lock, (int32_t)out_rel_lock, -1, 1, 2,
+                                 {out_buf0, out_buf1}};
+
+
+            objectfifo_acquire(&of_out);
+            int32_t *out = (int32_t *)objectfifo_get_buffer(&of_out, 0);
+            int freeOutBuf = 4096;
+            int outCount = 0;
+            int count_out_ac = 1;
+
+            //262144
+            //for (int i = 0; i < 65536; i++) {
+            //todo why are two loops not possible
+            for (int64_t i = 0; i < ((int64_t)iters_outer)*(int64_t)iters_inner; i++) {
+
+            //for (int i = 0; i < 512; i++) {
+            //for (int z = 0; z < 512; z++) {
+                objectfifo_acquire(&of_in);
+                int32_t *input = (int32_t *)objectfifo_get_buffer(&of_in, i);
+
+                objectfifo_acquire(&of_in_of_numer);
+                int32_t *numer_el = (int32_t *)objectfifo_get_buffer(&of_in_of_numer, i);
+                //event0();
+                *elems_produced += *numer_el;
+
+                auto to_copy = std::min(*numer_el,freeOutBuf);
+
+
+
+              for (int j = 0; j < to_copy; j += 1) // Nx samples per loop
+              {
+                out[j+outCount] = input[j];
+              }
+              freeOutBuf = freeOutBuf - to_copy;
+              outCount = outCount + to_copy;
+
+              if(freeOutBuf == 0){
+
+                objectfifo_release(&of_out);
+                objectfifo_acquire(&of_out);
+                out = (int32_t *)objectfifo_get_buffer(&of_out, count_out_ac);
+                count_out_ac ++;
+
+                freeOutBuf = 4096;
+                outCount =0;
+                for (int j = 0; j < ((*numer_el) - to_copy); j += 1) // Nx samples per loop
+                {
+                out[j] = input[j+to_copy];
+                }
+                freeOutBuf = freeOutBuf -((*numer_el) - to_copy);
+                outCount = outCount + ((*numer_el) - to_copy);
+              }
+                //event1();
+
+                objectfifo_release(&of_in_of_numer);
+                objectfifo_release(&of_in);
+
+            }//}
+            for (int j = outCount; j < 4096; j += 1){
+            out[j] = -1;
+            }
+            objectfifo_release(&of_out);
+
+         }
+
+
+
+
+
+//n_a / n_b are the valid elements of the two tiles, 64 except for the tail
+//tile of a relation whose size is not a multiple of 64; the rest of the
+//tile is padding and never matches
+#ifdef AIE_HOST_EMULATION
+//scalar model of the vector kernel below for the host emulation,
+//writes the matches in the same order (outer element major, inner element minor)
+void odd_even(int32_t * restrict input, int32_t * restrict input1,  int32_t * restrict value,const int32_t n_a,const int32_t n_b,int32_t * restrict elems_produced) {
+   int join_count = 0;
+   for (int i = 0; i < n_a; i++) {
+      for (int j = 0; j < n_b; j++) {
+        if (input[i] == input1[j]) {
+          value[join_count] = input1[j];
+          join_count++;
+        }
+      }
+   }
+   *elems_produced = join_count;
+}
+#else
+//lanes of the j-th 16 element vector of B that hold valid elements
+static inline aie::mask<16> valid_lanes(int32_t n_b, int j) {
+  int32_t n = n_b - 16 * j;
+  uint32_t bits = n >= 16 ? 0xFFFFu : (n <= 0 ? 0u : (1u << n) - 1);
+  return aie::mask<16>::from_uint32(bits);
+}
+
+//tail tile, same output order as the full tile below
+static inline void odd_even_masked(int32_t * restrict input, int32_t * restrict input1,  int32_t * restrict value,const int32_t n_a,const int32_t n_b,int32_t * restrict elems_produced) {
+   int join_count = 0;
+   int32_t *__restrict valuev = value;
+
+   for (int a = 0; a < n_a; a++) {
+      int32_t key = input[a];
+      int32_t *__restrict input1v = input1;
+      AIE_LOOP_UNROLL_FULL
+      for (int j = 0; j < 4; j++) {
+            aie::vector<int32_t, 16> A1 = aie::load_v<16>(input1v);
+            auto mask = aie::eq(A1,key) & valid_lanes(n_b, j);
+
+            aie::vector<int32_t, 16> comp_vec = aie::broadcast(-1);
+            int k = 0;
+            AIE_LOOP_UNROLL_FULL
+            for (int t = 0; t < 16; ++t) {
+                comp_vec[k] = mask.test(t) ? A1[t] : -1 ;
+                k = k + mask.test(t);
+            }
+            aie::store_unaligned_v(valuev,comp_vec);
+            valuev +=k;
+            join_count +=k;
+            input1v += 16;
+      }
+   }
+   *elems_produced = join_count;
+}
+
+void odd_even(int32_t * restrict input, int32_t * restrict input1,  int32_t * restrict value,const int32_t n_a,const int32_t n_b,int32_t * restrict elems_produced) {
+  if (n_a != 64 || n_b != 64) {
+    odd_even_masked(input, input1, value, n_a, n_b, elems_produced);
+    return;
+  }
+  //event0();
+
+
+
+   int join_count = 0;
+
+
+   int32_t *__restrict valuev = value;
+
+   int32_t *__restrict inputv = input;
+
+  AIE_PREPARE_FOR_PIPELINING
+  //AIE_LOOP_UNROLL(2)
+  AIE_LOOP_UNROLL_FULL
+  for (int i = 0; i < 4; i++) {
+        aie::vector<int32_t, 16> A0 = aie::load_v<16>(inputv);
+       //
+         //AIE_LOOP_UNROLL_FULL
+         //AIE_LOOP_UNROLL(2)
+         for (int z = 0; z < 16; z++) {
+            int32_t *__restrict input1v = input1;
+            AIE_LOOP_UNROLL_FULL
+           for (int j = 0; j < 4; j++) {
+
+            aie::vector<int32_t, 16> A1 = aie::load_v<16>(input1v);
+            auto mask =  aie::eq(A1,A0[z]);
+
+
+            aie::vector<int32_t, 16> comp_vec = aie::broadcast(-1);
+            int k = 0;
+            AIE_LOOP_UNROLL_FULL
+            for (int t = 0; t < 16; ++t) {
+                /*if (mask.test(t)) {
+                    comp_vec[k] = A1[t];
+                    k++;
+                }*/
+                comp_vec[k] = mask.test(t) ? A1[t] : -1 ;
+                k = k + mask.test(t);
+            }
+            aie::store_unaligned_v(valuev,comp_vec);
+            //aie::store_v(valuev,comp_vec);
+            //auto newvec = aie::select(-1,A1,mask);
+            //aie::store_v(valuev,newvec);
+            valuev +=k;
+
+            join_count +=k;
+
+            input1v += 16;
+       }
+       }
+       inputv +=16;
+
+}
+//todo vectorize this
+ /*for (auto vv = valuev; vv < value + 4096;vv++) {
+    *vv= -1;
+ }*/
+ //*elems_produced = value + 4096 - valuev;
+ *elems_produced = join_count;
+
+
+//event1();
+}
+#endif
+
+//zone maps: min / max of the valid elements of a tile. The core loop of
+//aie2.py only calls odd_even for an (outer, inner) tile pair whose key
+//ranges overlap, every other pair is answered with 0 matches right away.
+#ifdef AIE_HOST_EMULATION
+void tile_min_max(int32_t * restrict input, const int32_t n, int32_t * restrict zone) {
+   int32_t lo = INT32_MAX, hi = INT32_MIN;
+   for (int i = 0; i < n; i++) {
+      lo = std::min(lo, input[i]);
+      hi = std::max(hi, input[i]);
+   }
+   zone[0] = lo;
+   zone[1] = hi;
+}
+#else
+//same reduction as reduce_min.cc / reduce_max.cc, the pads of a tail tile
+//are replaced by the neutral element first
+void tile_min_max(int32_t * restrict input, const int32_t n, int32_t * restrict zone) {
+   aie::vector<int32_t, 16> lo = aie::broadcast<int32_t, 16>(INT32_MAX);
+   aie::vector<int32_t, 16> hi = aie::broadcast<int32_t, 16>(INT32_MIN);
+   AIE_LOOP_UNROLL_FULL
+   for (int j = 0; j < 4; j++) {
+      aie::vector<int32_t, 16> v = aie::load_v<16>(input + 16 * j);
+      aie::mask<16> valid = valid_lanes(n, j);
+      lo = aie::min(lo, aie::select(aie::broadcast<int32_t, 16>(INT32_MAX), v, valid));
+      hi = aie::max(hi, aie::select(aie::broadcast<int32_t, 16>(INT32_MIN), v, valid));
+   }
+   zone[0] = aie::reduce_min(lo);
+   zone[1] = aie::reduce_max(hi);
+}
+#endif
+
+//zone map of the inner tile into zone[0..1], zone[2] = 1 if it overlaps the
+//zone map of the outer tile (zone_a, from tile_min_max)
+void zone_overlap(int32_t * restrict input1, const int32_t n_b, int32_t * restrict zone_a, int32_t * restrict zone) {
+   tile_min_max(input1, n_b, zone);
+   zone[2] = zone_a[0] <= zone[1] && zone[0] <= zone_a[1];
+}
+
+} // extern "C"
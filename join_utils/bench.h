@@ -0,0 +1,269 @@
+//===- bench.h --------------------------------------------------*- C++ -*-===//
+//
+// Benchmark bookkeeping shared by the join harnesses.
+//
+// Bench collects the NPU (run) and CPU (reference) time of every measured
+// iteration, warmup iterations are dropped. summary() gives min / max /
+// mean / stddev and nearest rank p50 / p90 / p99. A BenchRecord tags the
+// result with the variant, compiler, sizes, selectivity, core count and
+// pipeline depth and derives the rates from the median run time. With a
+// pipeline depth above 1 the rates come from the pipeline time per
+// iteration instead, the throughput the overlapped loop reaches, and the
+// CPU reference is left out (empty summary) as it shares the host threads
+// with the input generation of the next iterations. Records are written as
+// one JSON object per line or as CSV rows with a header, both appended, so
+// a sweep script only has to remove the file once before it starts.
+// Variant specific values (host fallback time, skipped tiles, ...) go into
+// BenchRecord::extra and are written as additional columns / fields.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_BENCH_H
+#define JOIN_UTILS_BENCH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace join_utils {
+
+struct BenchSummary {
+  size_t n = 0;
+  double min = 0, max = 0, mean = 0, stddev = 0;
+  double p50 = 0, p90 = 0, p99 = 0;
+};
+
+// nearest rank percentile of sorted values
+inline double bench_percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+  return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+inline BenchSummary bench_summary(std::vector<double> values) {
+  BenchSummary s;
+  s.n = values.size();
+  if (values.empty())
+    return s;
+  std::sort(values.begin(), values.end());
+  s.min = values.front();
+  s.max = values.back();
+  double sum = 0;
+  for (double v : values)
+    sum += v;
+  s.mean = sum / s.n;
+  double sq = 0;
+  for (double v : values)
+    sq += (v - s.mean) * (v - s.mean);
+  // sample standard deviation, 0 for a single iteration
+  s.stddev = s.n > 1 ? std::sqrt(sq / (s.n - 1)) : 0;
+  s.p50 = bench_percentile(values, 50);
+  s.p90 = bench_percentile(values, 90);
+  s.p99 = bench_percentile(values, 99);
+  return s;
+}
+
+class Bench {
+public:
+  explicit Bench(int warmup_iterations) : warmup_(warmup_iterations) {}
+
+  // times in microseconds, iterations below the warmup count are dropped
+  void add(size_t iter, double npu_us, double cpu_us) {
+    add_npu(iter, npu_us);
+    add_cpu(iter, cpu_us);
+  }
+
+  // for loops that time the run and the (optional) reference separately
+  void add_npu(size_t iter, double us) {
+    if ((int64_t)iter >= warmup_)
+      npu_us_.push_back(us);
+  }
+  void add_cpu(size_t iter, double us) {
+    if ((int64_t)iter >= warmup_)
+      cpu_us_.push_back(us);
+  }
+
+  BenchSummary npu() const { return bench_summary(npu_us_); }
+  BenchSummary cpu() const { return bench_summary(cpu_us_); }
+  size_t measured() const { return npu_us_.size(); }
+
+private:
+  int64_t warmup_;
+  std::vector<double> npu_us_, cpu_us_;
+};
+
+struct BenchRecord {
+  std::string variant;
+  // peano, xchesscc or cpu (host emulation)
+  std::string compiler;
+  std::string backend;
+  int64_t size_a = 0;
+  int64_t size_b = 0;
+  double selectivity = 0;
+  int cores = 1;
+  uint64_t results = 0;
+  // bytes the host moves per run (inputs, produced output)
+  uint64_t bytes = 0;
+  int warmup = 0;
+  // buffer sets in flight (pipeline.h)
+  unsigned pipeline_depth = 1;
+  // pipeline time per iteration, used for the rates if pipeline_depth > 1
+  double pipeline_us = 0;
+  BenchSummary npu, cpu;
+  // variant specific (name, value) pairs, the same names for every record
+  // of a file
+  std::vector<std::pair<std::string, double>> extra;
+
+  // time per run the rates are derived from: the median run, or the
+  // pipeline time per iteration when runs overlap
+  double rate_us() const {
+    return pipeline_depth > 1 && pipeline_us > 0 ? pipeline_us : npu.p50;
+  }
+  double tuples_per_s() const {
+    return rate_us() > 0 ? (double)(size_a + size_b) / (rate_us() * 1e-6) : 0;
+  }
+  double comparisons_per_s() const {
+    return rate_us() > 0 ? (double)size_a * (double)size_b / (rate_us() * 1e-6) : 0;
+  }
+  double gb_per_s() const {
+    return rate_us() > 0 ? (double)bytes / (rate_us() * 1e-6) / 1e9 : 0;
+  }
+};
+
+inline void bench_print(std::ostream &os, const BenchRecord &r) {
+  auto line = [&os](const char *what, const BenchSummary &s) {
+    os << what << " time (us, " << s.n << " runs): min " << s.min << " p50 "
+       << s.p50 << " p90 " << s.p90 << " p99 " << s.p99 << " max " << s.max
+       << " mean " << s.mean << " stddev " << s.stddev << "\n";
+  };
+  line("NPU", r.npu);
+  if (r.cpu.n > 0)
+    line("CPU", r.cpu);
+  else
+    os << "CPU time: not recorded, the reference join overlapped the pipeline\n";
+  if (r.pipeline_depth > 1)
+    os << "pipeline depth " << r.pipeline_depth << ": " << r.pipeline_us
+       << "us per iteration\n";
+  os << "tuples/s: " << r.tuples_per_s()
+     << " comparisons/s: " << r.comparisons_per_s()
+     << " effective GB/s: " << r.gb_per_s() << "\n";
+  for (size_t i = 0; i < r.extra.size(); i++)
+    os << (i ? ", " : "") << r.extra[i].first << ": " << r.extra[i].second
+       << (i + 1 == r.extra.size() ? "\n" : "");
+}
+
+inline const char *bench_csv_header() {
+  return "variant;compiler;backend;size_a;size_b;selectivity;cores;results;"
+         "runs;warmup;pipeline_depth;pipeline_us;npu_min_us;npu_p50_us;npu_p90_us;npu_p99_us;npu_max_us;"
+         "npu_mean_us;npu_stddev_us;cpu_p50_us;cpu_mean_us;tuples_per_s;"
+         "comparisons_per_s;gb_per_s";
+}
+
+// the fixed columns plus the extra ones of r
+inline std::string bench_csv_header(const BenchRecord &r) {
+  std::string h = bench_csv_header();
+  for (auto &e : r.extra)
+    h += ";" + e.first;
+  return h;
+}
+
+inline void bench_write_csv_row(std::ostream &os, const BenchRecord &r) {
+  os << r.variant << ";" << r.compiler << ";" << r.backend << ";" << r.size_a
+     << ";" << r.size_b << ";" << r.selectivity << ";" << r.cores << ";"
+     << r.results << ";" << r.npu.n << ";" << r.warmup << ";"
+     << r.pipeline_depth << ";" << r.pipeline_us << ";" << r.npu.min
+     << ";" << r.npu.p50 << ";" << r.npu.p90 << ";" << r.npu.p99 << ";"
+     << r.npu.max << ";" << r.npu.mean << ";" << r.npu.stddev << ";";
+  // empty cpu columns if the reference was not recorded
+  if (r.cpu.n > 0)
+    os << r.cpu.p50 << ";" << r.cpu.mean;
+  else
+    os << ";";
+  os << ";" << r.tuples_per_s() << ";"
+     << r.comparisons_per_s() << ";" << r.gb_per_s();
+  for (auto &e : r.extra)
+    os << ";" << e.second;
+  os << "\n";
+}
+
+// the strings are names and compiler tags, only quotes and backslashes need
+// escaping
+inline std::string bench_json_string(const std::string &s) {
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\')
+      out += '\\';
+    out += c;
+  }
+  return out + "\"";
+}
+
+inline void bench_write_json(std::ostream &os, const BenchRecord &r) {
+  auto summary = [&os](const BenchSummary &s) {
+    if (s.n == 0) {
+      os << "null";
+      return;
+    }
+    os << "{\"runs\":" << s.n << ",\"min_us\":" << s.min << ",\"p50_us\":" << s.p50
+       << ",\"p90_us\":" << s.p90 << ",\"p99_us\":" << s.p99 << ",\"max_us\":" << s.max
+       << ",\"mean_us\":" << s.mean << ",\"stddev_us\":" << s.stddev << "}";
+  };
+  os << "{\"variant\":" << bench_json_string(r.variant)
+     << ",\"compiler\":" << bench_json_string(r.compiler)
+     << ",\"backend\":" << bench_json_string(r.backend)
+     << ",\"size_a\":" << r.size_a << ",\"size_b\":" << r.size_b
+     << ",\"selectivity\":" << r.selectivity << ",\"cores\":" << r.cores
+     << ",\"results\":" << r.results << ",\"bytes\":" << r.bytes
+     << ",\"warmup\":" << r.warmup << ",\"pipeline_depth\":" << r.pipeline_depth
+     << ",\"pipeline_us\":" << r.pipeline_us << ",\"npu\":";
+  summary(r.npu);
+  os << ",\"cpu\":";
+  summary(r.cpu);
+  os << ",\"tuples_per_s\":" << r.tuples_per_s()
+     << ",\"comparisons_per_s\":" << r.comparisons_per_s()
+     << ",\"gb_per_s\":" << r.gb_per_s();
+  for (auto &e : r.extra)
+    os << "," << bench_json_string(e.first) << ":" << e.second;
+  os << "}\n";
+}
+
+// Appends r to path, a CSV file gets the header first if it is new or empty.
+// Empty path writes nothing. Returns false if the file cannot be opened.
+inline bool bench_append_csv(const std::string &path, const BenchRecord &r) {
+  if (path.empty())
+    return true;
+  bool fresh;
+  {
+    std::ifstream in(path, std::ios::ate);
+    fresh = !in || in.tellg() <= 0;
+  }
+  std::ofstream out(path, std::ios_base::app | std::ios_base::out);
+  if (!out)
+    return false;
+  if (fresh)
+    out << bench_csv_header(r) << "\n";
+  bench_write_csv_row(out, r);
+  return true;
+}
+
+// one JSON object per line
+inline bool bench_append_json(const std::string &path, const BenchRecord &r) {
+  if (path.empty())
+    return true;
+  std::ofstream out(path, std::ios_base::app | std::ios_base::out);
+  if (!out)
+    return false;
+  bench_write_json(out, r);
+  return true;
+}
+
+} // namespace join_utils
+
+#endif
@@ -0,0 +1,191 @@
+//===- chunked_join.h -------------------------------------------*- C++ -*-===//
+//
+// Chunked streaming driver for relations larger than one launch of the join
+// design (join_new_chunked).
+//
+// The design is built for fixed block sizes (block_a x block_b). A and B
+// are split into blocks, every (A block, B block) pair is one launch, outer
+// block major. Partial last blocks are filled with the merge_path.h pads,
+// which never match a key or each other, so keys have to stay below
+// merge_pad_b (merge_keys_fit).
+//
+// Launches go through a Launcher with two buffer sets (in A, in B, out,
+// done, trace) in flight: while launch k runs, the completion thread drains
+// launch k - 1 into the ResultStore and the calling thread fills the next
+// free set with the blocks of launch k + 1. The buffers and the xrt::run are
+// reused across launches and calls of run(). The out buffer of a set only
+// has to hold the result of one block pair.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_CHUNKED_JOIN_H
+#define JOIN_UTILS_CHUNKED_JOIN_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "exec_backend.h"
+#include "launcher.h"
+#include "merge_path.h"
+#include "result_store.h"
+
+namespace join_utils {
+
+// Words the writeout core can write for one launch: the whole cross product
+// rounded up to 4096 word out buffers, plus the -1 padded buffer it always
+// ends with, at most one GB. Same formula as aie2.py of join_new_chunked.
+inline size_t chunk_out_words(size_t block_a, size_t block_b) {
+  return std::min<size_t>((block_a * block_b + 4095) / 4096 * 4096 + 4096,
+                          268435456);
+}
+
+struct ChunkedJoinConfig {
+  // must match the sizes the design was built for, multiples of 64
+  size_t block_a = 4096;
+  size_t block_b = 4096;
+  // trace buffer bound as the last kernel argument, 0 for none
+  size_t trace_bytes = 0;
+};
+
+struct ChunkedJoinStats {
+  size_t launches = 0;
+  double seconds = 0;
+  // host time spent waiting for launches, the rest overlapped with them
+  double wait_seconds = 0;
+  size_t results = 0;
+  size_t spilled_bytes = 0;
+  std::string error;
+};
+
+template <typename T> class ChunkedJoin {
+public:
+  ChunkedJoin(ExecBackend &backend, const ChunkedJoinConfig &config)
+      : config_(config), out_words_(chunk_out_words(config.block_a, config.block_b)) {
+    if (config_.block_a == 0 || config_.block_b == 0 ||
+        config_.block_a % 64 != 0 || config_.block_b % 64 != 0)
+      throw std::invalid_argument("chunked join: block sizes must be multiples of 64");
+    launcher_ = std::make_unique<Launcher>(
+        backend,
+        std::vector<LaunchArg>{{config_.block_a * sizeof(T), 3},
+                               {config_.block_b * sizeof(T), 4},
+                               {out_words_ * sizeof(T), 5},
+                               {16 * sizeof(uint32_t), 6},
+                               {std::max<size_t>(config_.trace_bytes, 1), 7}},
+        2);
+    launcher_->reserve(2);
+  }
+
+  size_t out_words() const { return out_words_; }
+
+  // Joins a with b, appends the join keys of every block pair to store.
+  // Returns false (stats->error says why) if a launch failed or reported
+  // more results than its out buffer holds.
+  bool run(const T *a, size_t n_a, const T *b, size_t n_b, ResultStore<T> &store,
+           ChunkedJoinStats *stats = nullptr) {
+    ChunkedJoinStats st;
+    auto start = std::chrono::high_resolution_clock::now();
+    if (!merge_keys_fit(a, n_a) || !merge_keys_fit(b, n_b)) {
+      st.error = "keys collide with the block pads";
+      return finish(st, start, store, stats);
+    }
+
+    size_t blocks_a = (n_a + config_.block_a - 1) / config_.block_a;
+    size_t blocks_b = (n_b + config_.block_b - 1) / config_.block_b;
+    size_t launches = blocks_a * blocks_b;
+
+    double blocked = launcher_->stats().blocked_seconds;
+    for (size_t k = 0; k < launches && !failed(st); k++) {
+      size_t block_a = k / blocks_b, block_b = k % blocks_b;
+      launcher_->submit(
+          [&, block_a, block_b](const Launcher::Buffers &buf) {
+            copy_block(buf[0], a, n_a, block_a, config_.block_a, merge_pad_a<T>());
+            copy_block(buf[1], b, n_b, block_b, config_.block_b, merge_pad_b<T>());
+            std::memset(buf[3]->map(), 0, 16 * sizeof(uint32_t));
+            buf[3]->sync(SyncDir::ToDevice);
+          },
+          [&](const Launcher::Buffers &buf, bool completed) {
+            drain(buf, completed, store, st);
+          });
+      st.launches++;
+    }
+    // a failed drain stops submitting, the launches in flight still finish
+    launcher_->wait_idle();
+    st.wait_seconds = launcher_->stats().blocked_seconds - blocked;
+    return finish(st, start, store, stats);
+  }
+
+private:
+  static void copy_block(Buffer *dst, const T *src, size_t n, size_t block,
+                         size_t block_elements, T pad) {
+    T *d = dst->map<T>();
+    size_t begin = block * block_elements;
+    size_t end = std::min(n, begin + block_elements);
+    std::copy(src + begin, src + end, d);
+    std::fill(d + (end - begin), d + block_elements, pad);
+    dst->sync(SyncDir::ToDevice);
+  }
+
+  bool failed(ChunkedJoinStats &st) {
+    std::lock_guard<std::mutex> lk(error_m_);
+    return !st.error.empty();
+  }
+
+  void fail(ChunkedJoinStats &st, std::string error) {
+    std::lock_guard<std::mutex> lk(error_m_);
+    if (st.error.empty())
+      st.error = std::move(error);
+  }
+
+  // runs on the completion thread, in launch order
+  void drain(const Launcher::Buffers &buf, bool completed, ResultStore<T> &store,
+             ChunkedJoinStats &st) {
+    if (failed(st))
+      return;
+    if (!completed) {
+      fail(st, "launch did not complete");
+      return;
+    }
+    Buffer *out = buf[2], *done = buf[3];
+    done->sync(SyncDir::FromDevice);
+    size_t n = done->template map<uint32_t>()[0];
+    if (n > out_words_) {
+      fail(st, "launch reported " + std::to_string(n) +
+                   " results, the out buffer holds " + std::to_string(out_words_));
+      return;
+    }
+    // only the produced prefix is synced and stored
+    if (n > 0) {
+      out->sync(SyncDir::FromDevice, n * sizeof(T), 0);
+      store.append(out->template map<T>(), n);
+    }
+  }
+
+  bool finish(ChunkedJoinStats &st, std::chrono::high_resolution_clock::time_point start,
+              const ResultStore<T> &store, ChunkedJoinStats *stats) {
+    st.seconds = std::chrono::duration<double>(
+                     std::chrono::high_resolution_clock::now() - start)
+                     .count();
+    st.results = store.size();
+    st.spilled_bytes = store.spilled_bytes();
+    if (stats)
+      *stats = st;
+    return st.error.empty();
+  }
+
+  ChunkedJoinConfig config_;
+  size_t out_words_;
+  std::mutex error_m_;
+  std::unique_ptr<Launcher> launcher_;
+};
+
+} // namespace join_utils
+
+#endif
@@ -0,0 +1,92 @@
+//===- compress.h -----------------------------------------------*- C++ -*-===//
+//
+// Vector compaction of one 16 lane int32 vector: the lanes selected by a
+// 16 bit mask are packed to lanes 0 .. k-1 in order, the other lanes get a
+// fill value.
+//
+// Every selected lane t moves down by the number of unselected lanes below
+// it. That distance is split into its bits and moved in 4 stages (1, 2, 4,
+// 8 lanes, lowest bit first, which never lets two lanes collide). The move
+// masks of the stages only depend on the mask, so they are computed on the
+// scalar unit with the parallel suffix method of Hacker's Delight (7-4,
+// compress); the vector unit then only does a shuffle_down and a select per
+// stage and one final select for the fill.
+//
+// Shared by the compacting kernels (join_new_vectorize_compress,
+// join_new_row_ids, join_new_payload), they include it relative to their
+// source. With -DAIE_HOST_EMULATION the vector part runs on a plain array
+// with the same lane semantics, for the golden test
+// (join_new_vectorize_compress/compress_golden.cpp).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_COMPRESS_H
+#define JOIN_UTILS_COMPRESS_H
+
+#include <stdint.h>
+
+struct compress_plan {
+  // lanes that move down by 1 << i in stage i
+  uint32_t mv[4];
+  // lanes 0 .. k-1 after the last stage
+  uint32_t keep;
+};
+
+static inline compress_plan compress_plan16(uint32_t m) {
+  compress_plan p;
+  m &= 0xFFFF;
+  //bit t of mk set: lane t - 1 is not selected, the parallel suffix turns
+  //that into the parity of the unselected lanes below t
+  uint32_t mk = ~m << 1;
+  for (int i = 0; i < 4; i++) {
+    uint32_t mp = mk ^ (mk << 1);
+    mp = mp ^ (mp << 2);
+    mp = mp ^ (mp << 4);
+    mp = mp ^ (mp << 8);
+    uint32_t mv = mp & m;
+    p.mv[i] = mv;
+    m = (m ^ mv) | (mv >> (1 << i));
+    mk = mk & ~mp;
+  }
+  p.keep = m;
+  return p;
+}
+
+#ifdef AIE_HOST_EMULATION
+struct compress_v16 {
+  int32_t e[16];
+};
+
+//lane q takes lane q + s where take has bit q set, like
+//select(v, shuffle_down(v, s), take) on the device
+static inline compress_v16 compress_stage(const compress_v16 &v, uint32_t take,
+                                          unsigned s) {
+  compress_v16 r = v;
+  for (unsigned q = 0; q + s < 16; q++)
+    if ((take >> q) & 1)
+      r.e[q] = v.e[q + s];
+  return r;
+}
+
+static inline compress_v16 compress16(compress_v16 v, const compress_plan &p,
+                                      int32_t fill) {
+  for (int i = 0; i < 4; i++)
+    v = compress_stage(v, p.mv[i] >> (1 << i), 1u << i);
+  for (int q = 0; q < 16; q++)
+    if (!((p.keep >> q) & 1))
+      v.e[q] = fill;
+  return v;
+}
+#else
+static inline aie::vector<int32_t, 16>
+compress16(aie::vector<int32_t, 16> v, const compress_plan &p, int32_t fill) {
+  v = aie::select(v, aie::shuffle_down(v, 1), aie::mask<16>::from_uint32(p.mv[0] >> 1));
+  v = aie::select(v, aie::shuffle_down(v, 2), aie::mask<16>::from_uint32(p.mv[1] >> 2));
+  v = aie::select(v, aie::shuffle_down(v, 4), aie::mask<16>::from_uint32(p.mv[2] >> 4));
+  v = aie::select(v, aie::shuffle_down(v, 8), aie::mask<16>::from_uint32(p.mv[3] >> 8));
+  return aie::select(aie::broadcast<int32_t, 16>(fill), v,
+                     aie::mask<16>::from_uint32(p.keep));
+}
+#endif
+
+#endif
@@ -0,0 +1,121 @@
+//===- core_stats.h ---------------------------------------------*- C++ -*-===//
+//
+// Decoder for the in-kernel cycle counters of join_new_vectorize_compress_cheat_dma.
+//
+// odd_even (core02) and writeout (core12) count core cycles per run and
+// core12 writes them into the outdone words after the join count:
+//   [1]      odd_even calls
+//   [2, 3]   cycles inside odd_even (compare)
+//   [4, 5]   cycles between two odd_even calls (lock waits of core02)
+//   [6, 7]   writeout cycles waiting for trans / of_numer_els (core02)
+//   [8, 9]   writeout cycles copying (compaction)
+//   [10, 11] writeout cycles waiting for an out buffer (output DMA)
+//   [12, 13] cycles of the whole writeout call
+//   [14]     out buffers written
+//   [15]     core_stats_tag, anything else is a design without counters
+// 64 bit counters are (low, high) word pairs. The host emulation counts
+// nanoseconds instead of cycles.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_CORE_STATS_H
+#define JOIN_UTILS_CORE_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace join_utils {
+
+constexpr uint32_t core_stats_tag = 0x53540001;
+
+struct CoreStats {
+  bool valid = false;
+  uint64_t odd_even_calls = 0;
+  uint64_t odd_even_cycles = 0;
+  uint64_t odd_even_wait_cycles = 0;
+  uint64_t writeout_in_wait_cycles = 0;
+  uint64_t writeout_copy_cycles = 0;
+  uint64_t writeout_out_wait_cycles = 0;
+  uint64_t writeout_cycles = 0;
+  uint64_t out_buffers = 0;
+
+  void add(const CoreStats &o) {
+    valid = valid || o.valid;
+    odd_even_calls += o.odd_even_calls;
+    odd_even_cycles += o.odd_even_cycles;
+    odd_even_wait_cycles += o.odd_even_wait_cycles;
+    writeout_in_wait_cycles += o.writeout_in_wait_cycles;
+    writeout_copy_cycles += o.writeout_copy_cycles;
+    writeout_out_wait_cycles += o.writeout_out_wait_cycles;
+    writeout_cycles += o.writeout_cycles;
+    out_buffers += o.out_buffers;
+  }
+};
+
+inline CoreStats decode_core_stats(const uint32_t *done) {
+  CoreStats s;
+  if (done[15] != core_stats_tag)
+    return s;
+  auto wide = [done](int i) { return (uint64_t)done[i] | ((uint64_t)done[i + 1] << 32); };
+  s.valid = true;
+  s.odd_even_calls = done[1];
+  s.odd_even_cycles = wide(2);
+  s.odd_even_wait_cycles = wide(4);
+  s.writeout_in_wait_cycles = wide(6);
+  s.writeout_copy_cycles = wide(8);
+  s.writeout_out_wait_cycles = wide(10);
+  s.writeout_cycles = wide(12);
+  s.out_buffers = done[14];
+  return s;
+}
+
+// Which part the design waits on. core12 waiting for its out buffers means
+// the output DMA is the limit. Otherwise core02 either compares or stalls
+// between two calls, and that gap holds both the acquire of the next input
+// tile and the acquire of trans / of_numer_els, so it can be the input DMA
+// or writeout not keeping up.
+inline const char *core_stats_bottleneck(const CoreStats &s) {
+  if (!s.valid || s.writeout_cycles == 0)
+    return "unknown";
+  double w = (double)s.writeout_cycles;
+  if (s.writeout_out_wait_cycles > 0.5 * w)
+    return "output DMA (writeout waits for out buffers)";
+  if (s.writeout_copy_cycles > 0.5 * w)
+    return "compaction (writeout copy)";
+  if (s.odd_even_cycles >= s.odd_even_wait_cycles)
+    return "compare (odd_even)";
+  return "core02 stalled on locks (input DMA or writeout back-pressure)";
+}
+
+inline void print_core_stats(std::ostream &os, const CoreStats &s, size_t runs) {
+  if (!s.valid) {
+    os << "core stats: not reported by the design\n";
+    return;
+  }
+  auto share = [](uint64_t part, uint64_t whole) {
+    return whole > 0 ? 100.0 * (double)part / (double)whole : 0.0;
+  };
+  uint64_t core02 = s.odd_even_cycles + s.odd_even_wait_cycles;
+  runs = runs > 0 ? runs : 1;
+  os << "core stats (" << runs << " runs, cycles per run):\n"
+     << "  odd_even: " << s.odd_even_calls / runs << " calls, "
+     << s.odd_even_cycles / runs << " compare ("
+     << share(s.odd_even_cycles, core02) << "%), " << s.odd_even_wait_cycles / runs
+     << " stalled on locks (" << share(s.odd_even_wait_cycles, core02) << "%), "
+     << (s.odd_even_calls ? s.odd_even_cycles / s.odd_even_calls : 0)
+     << " per call\n"
+     << "  writeout: " << s.writeout_cycles / runs << " total, "
+     << s.writeout_in_wait_cycles / runs << " waiting for input ("
+     << share(s.writeout_in_wait_cycles, s.writeout_cycles) << "%), "
+     << s.writeout_copy_cycles / runs << " copying ("
+     << share(s.writeout_copy_cycles, s.writeout_cycles) << "%), "
+     << s.writeout_out_wait_cycles / runs << " waiting for output ("
+     << share(s.writeout_out_wait_cycles, s.writeout_cycles) << "%), "
+     << s.out_buffers / runs << " out buffers\n"
+     << "  bottleneck: " << core_stats_bottleneck(s) << "\n";
+}
+
+} // namespace join_utils
+
+#endif
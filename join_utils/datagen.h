@@ -0,0 +1,235 @@
+//===- datagen.h ------------------------------------------------*- C++ -*-===//
+//
+// Multi-threaded synthetic input generator for the join harnesses.
+//
+// Keys are written straight into the (mapped) input buffers, split over the
+// worker threads. Every key is a function of (seed, iteration, side, index)
+// only: a splitmix64 counter stream per side and iteration, indexed by the
+// element. The threads never share generator state and the data does not
+// depend on the thread count.
+//
+// Distributions (domain is the --dist value):
+//   uniform      keys uniform in [1, domain]
+//   zipf         keys in [1, domain], P(k) ~ 1 / k^zipf_s on both sides
+//   foreign_key  B is a permutation of 1 .. n_b, every A key is one of them,
+//                so each A row matches exactly one B row
+//   selectivity  matches = selectivity * n_a * n_b, B holds every key of a
+//                1 / selectivity domain equally often (exact if that domain
+//                divides n_b), or n_b distinct keys and exactly that many A
+//                rows take one of them if the domain is larger than n_b
+//   all_equal    every key is 1, worst case: the full cross product matches
+//   no_match     A keys odd, B keys even, nothing matches but every pair is
+//                still compared
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_DATAGEN_H
+#define JOIN_UTILS_DATAGEN_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "hash_join.h"
+
+namespace join_utils {
+
+enum class KeyDist { uniform, zipf, foreign_key, selectivity, all_equal, no_match };
+
+inline const char *key_dist_name(KeyDist d) {
+  switch (d) {
+  case KeyDist::uniform: return "uniform";
+  case KeyDist::zipf: return "zipf";
+  case KeyDist::foreign_key: return "foreign_key";
+  case KeyDist::selectivity: return "selectivity";
+  case KeyDist::all_equal: return "all_equal";
+  case KeyDist::no_match: return "no_match";
+  }
+  return "unknown";
+}
+
+inline KeyDist parse_key_dist(const std::string &name) {
+  for (KeyDist d : {KeyDist::uniform, KeyDist::zipf, KeyDist::foreign_key,
+                    KeyDist::selectivity, KeyDist::all_equal, KeyDist::no_match})
+    if (name == key_dist_name(d))
+      return d;
+  throw std::invalid_argument("unknown key distribution: " + name);
+}
+
+struct DataGenConfig {
+  KeyDist dist = KeyDist::uniform;
+  // upper key of uniform, zipf and no_match
+  int64_t domain = 300;
+  double zipf_s = 1.0;
+  // selectivity distribution, 0 means 1 / domain
+  double selectivity = 0;
+  uint64_t seed = 12345;
+  unsigned threads = default_join_threads();
+};
+
+// splitmix64, element i of stream s is mix(s + (i + 1) * gamma)
+inline uint64_t datagen_mix(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+inline uint64_t datagen_random(uint64_t stream, uint64_t i) {
+  return datagen_mix(stream + (i + 1) * 0x9e3779b97f4a7c15ULL);
+}
+
+// [0, n), multiply shift, the bias is below 2^-32 for the sizes used here
+inline uint64_t datagen_below(uint64_t r, uint64_t n) {
+  return (uint64_t)(((unsigned __int128)r * n) >> 64);
+}
+
+// Keyed bijection on [0, n): an invertible mix on the next power of two,
+// repeated until the value falls below n (cycle walking, < 2 rounds on
+// average).
+class DataGenPermutation {
+public:
+  DataGenPermutation(uint64_t n, uint64_t key) : n_(std::max<uint64_t>(n, 1)) {
+    bits_ = 1;
+    while ((uint64_t(1) << bits_) < n_)
+      bits_++;
+    mask_ = bits_ >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits_) - 1;
+    for (int r = 0; r < 3; r++) {
+      mul_[r] = datagen_random(key, 2 * r) | 1;
+      add_[r] = datagen_random(key, 2 * r + 1);
+    }
+  }
+
+  uint64_t operator()(uint64_t x) const {
+    do {
+      for (int r = 0; r < 3; r++) {
+        x = (x * mul_[r] + add_[r]) & mask_;
+        x ^= x >> (bits_ / 2 + 1);
+      }
+    } while (x >= n_);
+    return x;
+  }
+
+private:
+  uint64_t n_, mask_, mul_[3], add_[3];
+  unsigned bits_;
+};
+
+template <typename T> class DataGen {
+public:
+  explicit DataGen(const DataGenConfig &config) : config_(config) {
+    if (config_.domain < 1)
+      throw std::invalid_argument("datagen: domain must be at least 1");
+    if (config_.dist == KeyDist::zipf) {
+      // cumulative weights of 1 .. domain, sampled by binary search
+      cdf_.resize((size_t)config_.domain);
+      double sum = 0;
+      for (size_t k = 0; k < cdf_.size(); k++)
+        cdf_[k] = sum += std::pow((double)(k + 1), -config_.zipf_s);
+      for (double &c : cdf_)
+        c /= sum;
+    }
+  }
+
+  const DataGenConfig &config() const { return config_; }
+
+  // Fills a[0 .. n_a) and b[0 .. n_b) with the keys of one iteration.
+  void fill(T *a, size_t n_a, T *b, size_t n_b, uint64_t iteration = 0) const {
+    uint64_t base = datagen_mix(config_.seed + iteration * 0xd1b54a32d192ed03ULL);
+    uint64_t stream_a = datagen_mix(base ^ 0xa), stream_b = datagen_mix(base ^ 0xb);
+
+    switch (config_.dist) {
+    case KeyDist::uniform:
+    case KeyDist::zipf:
+      fill_side(a, n_a, [&](size_t i) { return draw(datagen_random(stream_a, i)); });
+      fill_side(b, n_b, [&](size_t i) { return draw(datagen_random(stream_b, i)); });
+      break;
+    case KeyDist::foreign_key: {
+      DataGenPermutation pk(n_b, stream_b);
+      fill_side(b, n_b, [&](size_t i) { return (int64_t)pk(i) + 1; });
+      fill_side(a, n_a, [&](size_t i) {
+        return (int64_t)datagen_below(datagen_random(stream_a, i), std::max<size_t>(n_b, 1)) + 1;
+      });
+      break;
+    }
+    case KeyDist::selectivity:
+      fill_selectivity(a, n_a, b, n_b, stream_a, stream_b);
+      break;
+    case KeyDist::all_equal:
+      fill_side(a, n_a, [](size_t) { return (int64_t)1; });
+      fill_side(b, n_b, [](size_t) { return (int64_t)1; });
+      break;
+    case KeyDist::no_match:
+      fill_side(a, n_a, [&](size_t i) {
+        return 2 * (int64_t)datagen_below(datagen_random(stream_a, i), config_.domain) + 1;
+      });
+      fill_side(b, n_b, [&](size_t i) {
+        return 2 * (int64_t)datagen_below(datagen_random(stream_b, i), config_.domain) + 2;
+      });
+      break;
+    }
+  }
+
+  // key domain of the selectivity distribution
+  int64_t selectivity_domain() const {
+    if (config_.selectivity <= 0)
+      return config_.domain;
+    return std::max<int64_t>(1, std::llround(1.0 / config_.selectivity));
+  }
+
+private:
+  // uniform or zipf key in [1, domain]
+  int64_t draw(uint64_t r) const {
+    if (cdf_.empty())
+      return (int64_t)datagen_below(r, config_.domain) + 1;
+    double u = (double)(r >> 11) * 0x1.0p-53;
+    size_t k = std::upper_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+    return (int64_t)std::min(k, cdf_.size() - 1) + 1;
+  }
+
+  void fill_selectivity(T *a, size_t n_a, T *b, size_t n_b, uint64_t stream_a,
+                        uint64_t stream_b) const {
+    uint64_t d = (uint64_t)selectivity_domain();
+    DataGenPermutation keys(d, stream_b);
+    // B row j holds key slot j mod d, slot s is key keys(s) + 1
+    fill_side(b, n_b, [&](size_t j) { return (int64_t)keys(j % d) + 1; });
+    if (d <= n_b) {
+      // every slot is in B (n_b / d times), any A key from them matches
+      fill_side(a, n_a, [&](size_t i) {
+        return (int64_t)keys(datagen_below(datagen_random(stream_a, i), d)) + 1;
+      });
+      return;
+    }
+    // B holds slots 0 .. n_b - 1 once, the first `matching` rows of a
+    // permutation of A take one of those, the others a slot B does not hold
+    uint64_t matching = std::min<uint64_t>(
+        n_a, (uint64_t)std::llround((double)n_a * (double)n_b / (double)d));
+    DataGenPermutation rows(n_a, stream_a);
+    fill_side(a, n_a, [&](size_t i) {
+      uint64_t r = datagen_random(stream_a, i);
+      uint64_t slot = rows(i) < matching ? datagen_below(r, n_b)
+                                         : n_b + datagen_below(r, d - n_b);
+      return (int64_t)keys(slot) + 1;
+    });
+  }
+
+  template <typename Key> void fill_side(T *dst, size_t n, Key key) const {
+    // small inputs are not worth the thread start
+    unsigned threads = std::max(1u, std::min<unsigned>(config_.threads,
+                                                       (unsigned)(n / 65536 + 1)));
+    parallel_for_range(n, threads, [&](unsigned, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++)
+        dst[i] = (T)key(i);
+    });
+  }
+
+  DataGenConfig config_;
+  std::vector<double> cdf_;
+};
+
+} // namespace join_utils
+
+#endif
@@ -0,0 +1,115 @@
+//===- exec_backend.h -------------------------------------------*- C++ -*-===//
+//
+// Pluggable execution backend for the join harnesses.
+//
+// The harness allocates its buffers through a backend, maps and syncs them
+// like xrt::bo and starts the design with the buffers in kernel argument
+// order (everything after opcode, instruction BO and instruction count).
+// XrtBackend (xrt_backend.h) forwards to the NPU, CpuBackend runs a host
+// model of the design over plain host memory, so the host side of the
+// pipeline (generation, sync, verification) can be exercised anywhere.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_EXEC_BACKEND_H
+#define JOIN_UTILS_EXEC_BACKEND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace join_utils {
+
+enum class SyncDir { ToDevice, FromDevice };
+
+class Buffer {
+public:
+  virtual ~Buffer() = default;
+  virtual void *map() = 0;
+  virtual size_t size() const = 0;
+  virtual void sync(SyncDir dir) = 0;
+  virtual void sync(SyncDir dir, size_t bytes, size_t offset) = 0;
+
+  template <typename T> T *map() { return static_cast<T *>(map()); }
+};
+
+class Run {
+public:
+  virtual ~Run() = default;
+  // Blocks until the design finished, false if it did not complete.
+  virtual bool wait() = 0;
+};
+
+class ExecBackend {
+public:
+  virtual ~ExecBackend() = default;
+  virtual std::string name() const = 0;
+  // arg_index is the kernel argument the buffer is bound to, as passed to
+  // kernel.group_id() (3 for the first data buffer)
+  virtual std::unique_ptr<Buffer> alloc(size_t bytes, int arg_index) = 0;
+  virtual std::unique_ptr<Run> start(const std::vector<Buffer *> &args) = 0;
+};
+
+// Host memory, syncs are no-ops.
+class HostBuffer : public Buffer {
+public:
+  explicit HostBuffer(size_t bytes)
+      : bytes_(bytes), data_(new uint8_t[bytes > 0 ? bytes : 1]) {}
+  void *map() override { return data_.get(); }
+  size_t size() const override { return bytes_; }
+  void sync(SyncDir) override {}
+  void sync(SyncDir, size_t, size_t) override {}
+
+private:
+  size_t bytes_;
+  std::unique_ptr<uint8_t[]> data_;
+};
+
+// Runs a host model of the design on a worker thread. The model gets the
+// same buffers the NPU design would get and returns false on failure.
+class CpuBackend : public ExecBackend {
+public:
+  using Design = std::function<bool(const std::vector<Buffer *> &)>;
+
+  explicit CpuBackend(Design design) : design_(std::move(design)) {}
+
+  std::string name() const override { return "cpu"; }
+
+  std::unique_ptr<Buffer> alloc(size_t bytes, int) override {
+    return std::make_unique<HostBuffer>(bytes);
+  }
+
+  std::unique_ptr<Run> start(const std::vector<Buffer *> &args) override {
+    return std::make_unique<CpuRun>(design_, args);
+  }
+
+private:
+  class CpuRun : public Run {
+  public:
+    CpuRun(const Design &design, std::vector<Buffer *> args)
+        : worker_([this, design, args]() { ok_ = design(args); }) {}
+    ~CpuRun() override {
+      if (worker_.joinable())
+        worker_.join();
+    }
+    bool wait() override {
+      if (worker_.joinable())
+        worker_.join();
+      return ok_;
+    }
+
+  private:
+    bool ok_ = false;
+    std::thread worker_;
+  };
+
+  Design design_;
+};
+
+} // namespace join_utils
+
+#endif
@@ -0,0 +1,63 @@
+//===- gather.h -------------------------------------------------*- C++ -*-===//
+//
+// Late materialisation for the row id pair join (join_new_row_ids).
+//
+// The NPU only sees the keys and emits one 32 bit (row_a << 16 | row_b)
+// pair per match; the payload columns stay on the host and are gathered
+// through the pairs afterwards, split over the worker threads.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_GATHER_H
+#define JOIN_UTILS_GATHER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "hash_join.h"
+
+namespace join_utils {
+
+// rows per relation the 16|16 packing can address, the all ones pair is the
+// -1 padding of the output
+constexpr size_t row_id_limit = 0xFFFF;
+
+inline uint32_t pack_row_ids(uint32_t row_a, uint32_t row_b) {
+  return (row_a << 16) | (row_b & 0xFFFF);
+}
+inline uint32_t row_id_a(uint32_t pair) { return pair >> 16; }
+inline uint32_t row_id_b(uint32_t pair) { return pair & 0xFFFF; }
+
+// out_a[i] = payload_a[row_a of pairs[i]], out_b[i] = payload_b[row_b of
+// pairs[i]]. Either payload may be nullptr to gather only one side.
+template <typename PA, typename PB>
+void gather_pairs(const uint32_t *pairs, size_t n, const PA *payload_a,
+                  const PB *payload_b, PA *out_a, PB *out_b,
+                  unsigned n_threads = default_join_threads()) {
+  n_threads = std::max(1u, std::min<unsigned>(n_threads, (unsigned)(n / 65536 + 1)));
+  parallel_for_range(n, n_threads, [&](unsigned, size_t begin, size_t end) {
+    if (payload_a)
+      for (size_t i = begin; i < end; i++)
+        out_a[i] = payload_a[row_id_a(pairs[i])];
+    if (payload_b)
+      for (size_t i = begin; i < end; i++)
+        out_b[i] = payload_b[row_id_b(pairs[i])];
+  });
+}
+
+// Single column variant, e.g. to materialise the key itself.
+template <typename P>
+void gather_column(const uint32_t *pairs, size_t n, const P *payload,
+                   bool side_a, P *out,
+                   unsigned n_threads = default_join_threads()) {
+  n_threads = std::max(1u, std::min<unsigned>(n_threads, (unsigned)(n / 65536 + 1)));
+  parallel_for_range(n, n_threads, [&](unsigned, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+      out[i] = payload[side_a ? row_id_a(pairs[i]) : row_id_b(pairs[i])];
+  });
+}
+
+} // namespace join_utils
+
+#endif
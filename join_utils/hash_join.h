@@ -0,0 +1,230 @@
+//===- hash_join.h ----------------------------------------------*- C++ -*-===//
+//
+// Multi-threaded radix-partitioned hash join used as the host reference in
+// the join harnesses.
+//
+// Both relations are scattered into 2^radix_bits partitions by the low bits
+// of a mixed key hash (histogram, prefix sum, scatter, each pass split over
+// the worker threads). Partitions are then joined independently: the inner
+// partition is built into a small open-addressing table of (key, count) and
+// the outer partition probes it. A probe hit with count c emits c copies of
+// the key into the match list and adds c to the key's multiplicity, so the
+// match list and the per-key histogram come out of a single pass.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_HASH_JOIN_H
+#define JOIN_UTILS_HASH_JOIN_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace join_utils {
+
+template <typename T> struct JoinResult {
+  // one entry per matching (outer, inner) pair, value is the join key
+  std::vector<T> matches;
+  // (key, number of matching pairs) sorted by key
+  std::vector<std::pair<T, size_t>> histogram;
+};
+
+inline uint32_t mix_key(uint64_t k) {
+  // murmur3 finalizer, keeps consecutive keys apart in the low bits
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return (uint32_t)k;
+}
+
+inline unsigned default_join_threads() {
+  unsigned n = std::thread::hardware_concurrency();
+  return n == 0 ? 1 : n;
+}
+
+// Runs fn(thread_id, begin, end) on n_threads threads over [0, n).
+template <typename Fn>
+void parallel_for_range(size_t n, unsigned n_threads, Fn &&fn) {
+  n_threads = std::max(1u, std::min<unsigned>(n_threads, (unsigned)std::max<size_t>(n, 1)));
+  if (n_threads == 1) {
+    fn(0u, (size_t)0, n);
+    return;
+  }
+  std::vector<std::thread> workers;
+  workers.reserve(n_threads);
+  size_t chunk = (n + n_threads - 1) / n_threads;
+  for (unsigned t = 0; t < n_threads; t++) {
+    size_t begin = std::min(n, t * chunk);
+    size_t end = std::min(n, begin + chunk);
+    workers.emplace_back([&fn, t, begin, end]() { fn(t, begin, end); });
+  }
+  for (auto &w : workers)
+    w.join();
+}
+
+// Radix partitioning of one relation. part_begin has n_parts + 1 entries,
+// partition p lives in out[part_begin[p] .. part_begin[p+1]).
+template <typename T> struct Partitioned {
+  std::vector<T> out;
+  std::vector<size_t> part_begin;
+};
+
+template <typename T>
+Partitioned<T> radix_partition(const T *in, size_t n, unsigned radix_bits,
+                               unsigned n_threads) {
+  const size_t n_parts = size_t(1) << radix_bits;
+  const uint32_t mask = (uint32_t)(n_parts - 1);
+  n_threads = std::max(1u, std::min<unsigned>(n_threads, (unsigned)std::max<size_t>(n, 1)));
+
+  // per thread histograms, laid out [thread][partition]
+  std::vector<size_t> hist(n_threads * n_parts, 0);
+  size_t chunk = (n + n_threads - 1) / n_threads;
+
+  parallel_for_range(n_threads, n_threads, [&](unsigned, size_t tb, size_t te) {
+    for (size_t t = tb; t < te; t++) {
+      size_t *h = &hist[t * n_parts];
+      size_t begin = std::min(n, t * chunk);
+      size_t end = std::min(n, begin + chunk);
+      for (size_t i = begin; i < end; i++)
+        h[mix_key((uint64_t)in[i]) & mask]++;
+    }
+  });
+
+  // exclusive prefix sum in partition-major order, so every thread owns a
+  // contiguous write window inside each partition
+  Partitioned<T> res;
+  res.out.resize(n);
+  res.part_begin.assign(n_parts + 1, 0);
+  std::vector<size_t> offset(n_threads * n_parts);
+  size_t sum = 0;
+  for (size_t p = 0; p < n_parts; p++) {
+    res.part_begin[p] = sum;
+    for (unsigned t = 0; t < n_threads; t++) {
+      offset[t * n_parts + p] = sum;
+      sum += hist[t * n_parts + p];
+    }
+  }
+  res.part_begin[n_parts] = sum;
+
+  parallel_for_range(n_threads, n_threads, [&](unsigned, size_t tb, size_t te) {
+    for (size_t t = tb; t < te; t++) {
+      size_t *off = &offset[t * n_parts];
+      size_t begin = std::min(n, t * chunk);
+      size_t end = std::min(n, begin + chunk);
+      for (size_t i = begin; i < end; i++)
+        res.out[off[mix_key((uint64_t)in[i]) & mask]++] = in[i];
+    }
+  });
+  return res;
+}
+
+// Picks enough partitions that an inner partition stays around L2 sized.
+inline unsigned default_radix_bits(size_t inner_elements) {
+  unsigned bits = 0;
+  while (bits < 12 && (inner_elements >> bits) > 4096)
+    bits++;
+  return std::max(bits, 4u);
+}
+
+// Inner join of a (outer) and b (inner) on equality of the keys.
+// If want_matches is false only the histogram is produced.
+template <typename T>
+JoinResult<T> radix_hash_join(const T *a, size_t n_a, const T *b, size_t n_b,
+                              bool want_matches = true,
+                              unsigned n_threads = default_join_threads(),
+                              unsigned radix_bits = 0) {
+  if (radix_bits == 0)
+    radix_bits = default_radix_bits(n_b);
+  const size_t n_parts = size_t(1) << radix_bits;
+
+  Partitioned<T> pa = radix_partition(a, n_a, radix_bits, n_threads);
+  Partitioned<T> pb = radix_partition(b, n_b, radix_bits, n_threads);
+
+  struct Local {
+    std::vector<T> matches;
+    std::vector<std::pair<T, size_t>> histogram;
+  };
+  n_threads = std::max(1u, std::min<unsigned>(n_threads, (unsigned)n_parts));
+  std::vector<Local> locals(n_threads);
+  std::atomic<size_t> next_part{0};
+
+  parallel_for_range(n_threads, n_threads, [&](unsigned, size_t tb, size_t te) {
+    for (size_t t = tb; t < te; t++) {
+      Local &local = locals[t];
+      std::vector<T> keys;
+      std::vector<uint32_t> counts;
+      std::vector<size_t> hits;
+      for (size_t p = next_part++; p < n_parts; p = next_part++) {
+        const T *pb_begin = pb.out.data() + pb.part_begin[p];
+        size_t pb_n = pb.part_begin[p + 1] - pb.part_begin[p];
+        const T *pa_begin = pa.out.data() + pa.part_begin[p];
+        size_t pa_n = pa.part_begin[p + 1] - pa.part_begin[p];
+        if (pb_n == 0 || pa_n == 0)
+          continue;
+
+        // build: open addressing on the hash bits above the radix bits,
+        // count 0 marks an empty slot
+        size_t cap = 16;
+        while (cap < 2 * pb_n)
+          cap <<= 1;
+        const size_t slot_mask = cap - 1;
+        keys.assign(cap, T{});
+        counts.assign(cap, 0);
+        hits.assign(cap, 0);
+        for (size_t i = 0; i < pb_n; i++) {
+          T k = pb_begin[i];
+          size_t s = (mix_key((uint64_t)k) >> radix_bits) & slot_mask;
+          while (counts[s] != 0 && keys[s] != k)
+            s = (s + 1) & slot_mask;
+          keys[s] = k;
+          counts[s]++;
+        }
+
+        // probe
+        for (size_t i = 0; i < pa_n; i++) {
+          T k = pa_begin[i];
+          size_t s = (mix_key((uint64_t)k) >> radix_bits) & slot_mask;
+          while (counts[s] != 0 && keys[s] != k)
+            s = (s + 1) & slot_mask;
+          if (counts[s] == 0)
+            continue;
+          hits[s] += counts[s];
+          if (want_matches)
+            local.matches.insert(local.matches.end(), counts[s], k);
+        }
+
+        // partitions have disjoint key sets, so the per partition
+        // histograms can simply be concatenated
+        for (size_t s = 0; s < cap; s++)
+          if (hits[s] != 0)
+            local.histogram.emplace_back(keys[s], hits[s]);
+      }
+    }
+  });
+
+  JoinResult<T> res;
+  size_t n_matches = 0, n_keys = 0;
+  for (auto &l : locals) {
+    n_matches += l.matches.size();
+    n_keys += l.histogram.size();
+  }
+  res.matches.reserve(n_matches);
+  res.histogram.reserve(n_keys);
+  for (auto &l : locals) {
+    res.matches.insert(res.matches.end(), l.matches.begin(), l.matches.end());
+    res.histogram.insert(res.histogram.end(), l.histogram.begin(),
+                         l.histogram.end());
+  }
+  std::sort(res.histogram.begin(), res.histogram.end());
+  return res;
+}
+
+} // namespace join_utils
+
+#endif
@@ -0,0 +1,47 @@
+//===- aie_objectfifo.h - host emulation ------------------------*- C++ -*-===//
+//
+// Drop-in replacement for aie_runtime_lib/AIE2/aie_objectfifo.h used when a
+// kernel is compiled for x86 with -DAIE_HOST_EMULATION. Same objectfifo_t
+// layout and functions, but the locks are the host_aie::LockTable
+// semaphores, so producer and consumer kernels can run as std::threads.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef AIE_OBJECTFIFO_H
+#define AIE_OBJECTFIFO_H
+
+#include <stdint.h>
+
+#include "host_locks.h"
+
+// the AIE compilers accept C99 restrict in C++ kernels, g++ does not
+#ifndef restrict
+#define restrict __restrict
+#endif
+
+#ifndef OBJECTFIFO_MAX_BUFFERS
+#define OBJECTFIFO_MAX_BUFFERS 8
+#endif
+
+typedef struct {
+  int32_t acq_lock;
+  int32_t rel_lock;
+  int32_t acq_value;
+  int32_t rel_value;
+  int32_t num_buffers;
+  void *buffers[OBJECTFIFO_MAX_BUFFERS];
+} objectfifo_t;
+
+static inline void objectfifo_acquire(objectfifo_t *of) {
+  host_aie::lock_acquire(of->acq_lock, of->acq_value);
+}
+
+static inline void objectfifo_release(objectfifo_t *of) {
+  host_aie::lock_release(of->rel_lock, of->rel_value);
+}
+
+static inline void *objectfifo_get_buffer(objectfifo_t *of, int64_t index) {
+  return of->buffers[index % of->num_buffers];
+}
+
+#endif
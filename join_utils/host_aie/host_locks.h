@@ -0,0 +1,264 @@
+//===- host_locks.h ---------------------------------------------*- C++ -*-===//
+//
+// Host emulation of AIE2 tile locks and object fifos.
+//
+// A lock is a counting semaphore with the AIE2 acquire semantics:
+//   acquire(v), v < 0 : wait until value >= -v, then value += v
+//   acquire(v), v >= 0: wait until value == v, then value -= v
+//   release(v)        : value += v
+// Lock ids index a process wide table, so the int32 ids handed to the
+// kernels through objectfifo_t work unchanged. An acquire that waits longer
+// than the configured timeout is reported as a deadlock by throwing
+// lock_timeout, which the core thread running the kernel can catch.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_HOST_LOCKS_H
+#define JOIN_UTILS_HOST_LOCKS_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace host_aie {
+
+struct lock_timeout : std::runtime_error {
+  int32_t lock_id;
+  int32_t value;
+  int32_t wanted;
+  lock_timeout(int32_t id, int32_t v, int32_t w)
+      : std::runtime_error("lock " + std::to_string(id) + " stuck at " +
+                           std::to_string(v) + ", acquire(" +
+                           std::to_string(w) + ") timed out"),
+        lock_id(id), value(v), wanted(w) {}
+};
+
+struct lock_shutdown : std::runtime_error {
+  lock_shutdown() : std::runtime_error("lock table shut down") {}
+};
+
+class Semaphore {
+public:
+  explicit Semaphore(int32_t init = 0) : value_(init) {}
+
+  void acquire(int32_t v, int32_t id, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lk(m_);
+    auto ready = [&] {
+      return shutdown_ || (v < 0 ? value_ >= -v : value_ == v);
+    };
+    acquires_++;
+    if (!ready()) {
+      blocked_++;
+      auto t0 = std::chrono::steady_clock::now();
+      bool ok = cv_.wait_for(lk, timeout, ready);
+      wait_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - t0)
+                      .count();
+      if (!ok)
+        throw lock_timeout(id, value_, v);
+    }
+    if (shutdown_ && !(v < 0 ? value_ >= -v : value_ == v))
+      throw lock_shutdown();
+    value_ += v < 0 ? v : -v;
+  }
+
+  // Non throwing acquire for host side consumers (the shim DMA drain),
+  // returns false once the table is shut down and nothing is left.
+  bool try_acquire_until_shutdown(int32_t v) {
+    std::unique_lock<std::mutex> lk(m_);
+    auto ok = [&] { return v < 0 ? value_ >= -v : value_ == v; };
+    cv_.wait(lk, [&] { return shutdown_ || ok(); });
+    if (!ok())
+      return false;
+    value_ += v < 0 ? v : -v;
+    return true;
+  }
+
+  void release(int32_t v) {
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      value_ += v;
+    }
+    cv_.notify_all();
+  }
+
+  void shutdown() {
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      shutdown_ = true;
+    }
+    cv_.notify_all();
+  }
+
+  void reset(int32_t init) {
+    std::lock_guard<std::mutex> lk(m_);
+    value_ = init;
+    shutdown_ = false;
+    acquires_ = blocked_ = 0;
+    wait_ns_ = 0;
+  }
+
+  int32_t value() {
+    std::lock_guard<std::mutex> lk(m_);
+    return value_;
+  }
+  uint64_t acquires() {
+    std::lock_guard<std::mutex> lk(m_);
+    return acquires_;
+  }
+  uint64_t blocked() {
+    std::lock_guard<std::mutex> lk(m_);
+    return blocked_;
+  }
+  uint64_t wait_ns() {
+    std::lock_guard<std::mutex> lk(m_);
+    return wait_ns_;
+  }
+
+private:
+  std::mutex m_;
+  std::condition_variable cv_;
+  int32_t value_;
+  bool shutdown_ = false;
+  uint64_t acquires_ = 0;
+  uint64_t blocked_ = 0;
+  uint64_t wait_ns_ = 0;
+};
+
+class LockTable {
+public:
+  static LockTable &get() {
+    static LockTable table;
+    return table;
+  }
+
+  int32_t alloc(int32_t init, std::string name = "") {
+    std::lock_guard<std::mutex> lk(m_);
+    locks_.emplace_back(init);
+    names_.push_back(std::move(name));
+    return (int32_t)locks_.size() - 1;
+  }
+
+  Semaphore &operator[](int32_t id) {
+    // deque keeps references stable while other threads allocate
+    std::lock_guard<std::mutex> lk(m_);
+    return locks_.at(id);
+  }
+
+  const std::string &name(int32_t id) {
+    std::lock_guard<std::mutex> lk(m_);
+    return names_.at(id);
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lk(m_);
+    return locks_.size();
+  }
+
+  // Wakes every waiter, used to tear down a run after a deadlock or once
+  // the consumers are done.
+  void shutdown() {
+    for (size_t i = 0; i < size(); i++)
+      (*this)[(int32_t)i].shutdown();
+  }
+
+  // Forgets all locks; only valid while no core thread is running.
+  void clear() {
+    std::lock_guard<std::mutex> lk(m_);
+    locks_.clear();
+    names_.clear();
+  }
+
+  std::chrono::milliseconds timeout{10000};
+
+private:
+  std::mutex m_;
+  std::deque<Semaphore> locks_;
+  std::vector<std::string> names_;
+};
+
+inline void lock_acquire(int32_t id, int32_t value) {
+  LockTable &t = LockTable::get();
+  t[id].acquire(value, id, t.timeout);
+}
+
+inline void lock_release(int32_t id, int32_t value) {
+  LockTable::get()[id].release(value);
+}
+
+// Host model of an aie.objectfifo between one producer and one consumer.
+// Like the AIE2 lowering it owns depth buffers, a producer lock initialised
+// to depth and a consumer lock initialised to 0. acquire()/release() mirror
+// the compiler managed ObjectFifo.acquire/release of aie2.py and rotate
+// through the buffers on their own; acq_lock()/rel_lock() return the lock
+// ids a kernel side objectfifo_t is built from (what get_lock() passes).
+template <typename T> class ObjectFifo {
+public:
+  enum Port { Produce, Consume };
+
+  ObjectFifo(std::string name, int32_t depth, size_t elements)
+      : name_(std::move(name)), depth_(depth),
+        buffers_(depth, std::vector<T>(elements)) {
+    LockTable &t = LockTable::get();
+    prod_lock_ = t.alloc(depth, name_ + "_prod_lock");
+    cons_lock_ = t.alloc(0, name_ + "_cons_lock");
+  }
+
+  T *acquire(Port port) {
+    if (port == Produce) {
+      lock_acquire(prod_lock_, -1);
+      return buffers_[prod_idx_].data();
+    }
+    lock_acquire(cons_lock_, -1);
+    return buffers_[cons_idx_].data();
+  }
+
+  // Returns nullptr if the fifo was shut down while waiting.
+  T *acquire_until_shutdown(Port port) {
+    Semaphore &s = LockTable::get()[port == Produce ? prod_lock_ : cons_lock_];
+    if (!s.try_acquire_until_shutdown(-1))
+      return nullptr;
+    return buffers_[port == Produce ? prod_idx_ : cons_idx_].data();
+  }
+
+  void release(Port port) {
+    if (port == Produce) {
+      prod_idx_ = (prod_idx_ + 1) % depth_;
+      lock_release(cons_lock_, 1);
+    } else {
+      cons_idx_ = (cons_idx_ + 1) % depth_;
+      lock_release(prod_lock_, 1);
+    }
+  }
+
+  T *get_buffer(int32_t i) { return buffers_[i].data(); }
+  int32_t depth() const { return depth_; }
+  size_t elements() const { return buffers_[0].size(); }
+
+  int32_t acq_lock(Port port) const {
+    return port == Produce ? prod_lock_ : cons_lock_;
+  }
+  int32_t rel_lock(Port port) const {
+    return port == Produce ? cons_lock_ : prod_lock_;
+  }
+
+  const std::string &name() const { return name_; }
+
+private:
+  std::string name_;
+  int32_t depth_;
+  std::vector<std::vector<T>> buffers_;
+  int32_t prod_lock_;
+  int32_t cons_lock_;
+  int32_t prod_idx_ = 0;
+  int32_t cons_idx_ = 0;
+};
+
+} // namespace host_aie
+
+#endif
@@ -0,0 +1,316 @@
+//===- join_verify.h --------------------------------------------*- C++ -*-===//
+//
+// Streaming multiset verifier for the join output buffer.
+//
+// Only the produced prefix of the output is read. The common (passing) case
+// is a single parallel pass that sums a mixed hash of every output value;
+// addition is order independent, so the sum equals the same sum taken over
+// the reference histogram iff both multisets agree (up to hash collisions).
+// Only on a fingerprint or length mismatch the output is counted per key
+// (a flat array when the key domain is small) to find the first differing
+// key.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_JOIN_VERIFY_H
+#define JOIN_UTILS_JOIN_VERIFY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "hash_join.h"
+
+namespace join_utils {
+
+template <typename T> struct VerifyResult {
+  bool equal = true;
+  // only valid if !equal
+  T key{};
+  size_t expected = 0;
+  size_t got = 0;
+};
+
+inline uint64_t fingerprint_key(uint64_t k) {
+  // splitmix64 finalizer, full 64 bit avalanche so sums do not cancel
+  k += 0x9e3779b97f4a7c15ULL;
+  k = (k ^ (k >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  k = (k ^ (k >> 27)) * 0x94d049bb133111ebULL;
+  return k ^ (k >> 31);
+}
+
+template <typename T>
+uint64_t fingerprint(const T *values, size_t n,
+                     unsigned n_threads = default_join_threads()) {
+  n_threads = std::max(1u, std::min<unsigned>(n_threads, (unsigned)(n / 65536 + 1)));
+  std::vector<uint64_t> partial(n_threads, 0);
+  parallel_for_range(n, n_threads, [&](unsigned t, size_t begin, size_t end) {
+    uint64_t sum = 0;
+    for (size_t i = begin; i < end; i++)
+      sum += fingerprint_key((uint64_t)values[i]);
+    partial[t] = sum;
+  });
+  uint64_t sum = 0;
+  for (uint64_t p : partial)
+    sum += p;
+  return sum;
+}
+
+template <typename T>
+uint64_t fingerprint(const std::vector<std::pair<T, size_t>> &histogram) {
+  uint64_t sum = 0;
+  for (auto &kv : histogram)
+    sum += fingerprint_key((uint64_t)kv.first) * (uint64_t)kv.second;
+  return sum;
+}
+
+// Slow path, counts the output per key and returns the smallest key whose
+// count differs from the (sorted) reference histogram.
+template <typename T>
+VerifyResult<T> first_difference(const T *out, size_t n_out,
+                                 const std::vector<std::pair<T, size_t>> &histogram) {
+  VerifyResult<T> res;
+  res.equal = false;
+
+  std::vector<std::pair<T, size_t>> got;
+  int64_t lo = histogram.empty() ? 0 : (int64_t)histogram.front().first;
+  int64_t hi = histogram.empty() ? -1 : (int64_t)histogram.back().first;
+  bool in_domain = true;
+  for (size_t i = 0; i < n_out && in_domain; i++)
+    in_domain = (int64_t)out[i] >= lo && (int64_t)out[i] <= hi;
+
+  if (in_domain && hi - lo < (int64_t)(1 << 24)) {
+    std::vector<size_t> counts((size_t)(hi - lo + 1), 0);
+    for (size_t i = 0; i < n_out; i++)
+      counts[(size_t)((int64_t)out[i] - lo)]++;
+    for (size_t k = 0; k < counts.size(); k++)
+      if (counts[k] != 0)
+        got.emplace_back((T)((int64_t)k + lo), counts[k]);
+  } else {
+    std::unordered_map<T, size_t> counts;
+    for (size_t i = 0; i < n_out; i++)
+      counts[out[i]]++;
+    got.assign(counts.begin(), counts.end());
+    std::sort(got.begin(), got.end());
+  }
+
+  // walk both sorted histograms, the first key where they differ wins
+  size_t r = 0, g = 0;
+  while (r < histogram.size() || g < got.size()) {
+    if (g == got.size() ||
+        (r < histogram.size() && histogram[r].first < got[g].first)) {
+      res.key = histogram[r].first;
+      res.expected = histogram[r].second;
+      return res;
+    }
+    if (r == histogram.size() || got[g].first < histogram[r].first) {
+      res.key = got[g].first;
+      res.got = got[g].second;
+      return res;
+    }
+    if (histogram[r].second != got[g].second) {
+      res.key = histogram[r].first;
+      res.expected = histogram[r].second;
+      res.got = got[g].second;
+      return res;
+    }
+    r++;
+    g++;
+  }
+  // fingerprint collision on unequal lengths cannot happen, so only a hash
+  // collision ends up here
+  res.equal = true;
+  return res;
+}
+
+// Checks that out[0 .. n_out) is a permutation of the multiset described by
+// histogram (sorted by key, as returned by radix_hash_join).
+template <typename T>
+VerifyResult<T> verify_join_output(const T *out, size_t n_out,
+                                   const std::vector<std::pair<T, size_t>> &histogram,
+                                   unsigned n_threads = default_join_threads()) {
+  size_t n_ref = 0;
+  for (auto &kv : histogram)
+    n_ref += kv.second;
+
+  if (n_ref == n_out && fingerprint(out, n_out, n_threads) == fingerprint(histogram))
+    return VerifyResult<T>{};
+  return first_difference(out, n_out, histogram);
+}
+
+// Output held in segments (result_store.h), for_each_segment(fn) calls
+// fn(values, n) per segment. Only a mismatch gathers the segments.
+template <typename T, typename ForEachSegment>
+VerifyResult<T> verify_join_segments(ForEachSegment &&for_each_segment,
+                                     const std::vector<std::pair<T, size_t>> &histogram,
+                                     unsigned n_threads = default_join_threads()) {
+  size_t n_ref = 0;
+  for (auto &kv : histogram)
+    n_ref += kv.second;
+
+  size_t n_out = 0;
+  uint64_t sum = 0;
+  for_each_segment([&](const T *values, size_t n) {
+    n_out += n;
+    sum += fingerprint(values, n, n_threads);
+  });
+  if (n_ref == n_out && sum == fingerprint(histogram))
+    return VerifyResult<T>{};
+
+  std::vector<T> out;
+  out.reserve(n_out);
+  for_each_segment([&](const T *values, size_t n) {
+    out.insert(out.end(), values, values + n);
+  });
+  return first_difference(out.data(), out.size(), histogram);
+}
+
+// Run length encoded output, n_words / 2 (key, count) pairs (rle_decoder.h).
+// The fingerprint is taken over the runs, only a mismatch expands them.
+template <typename T>
+VerifyResult<T> verify_rle_output(const T *words, size_t n_words,
+                                  const std::vector<std::pair<T, size_t>> &histogram) {
+  size_t n_ref = 0;
+  for (auto &kv : histogram)
+    n_ref += kv.second;
+
+  size_t n_out = 0;
+  uint64_t sum = 0;
+  for (size_t p = 0; p + 1 < n_words; p += 2) {
+    size_t count = words[p + 1] > 0 ? (size_t)words[p + 1] : 0;
+    n_out += count;
+    sum += fingerprint_key((uint64_t)words[p]) * (uint64_t)count;
+  }
+  if (n_ref == n_out && sum == fingerprint(histogram))
+    return VerifyResult<T>{};
+
+  std::vector<T> out;
+  for (size_t p = 0; p + 1 < n_words; p += 2)
+    if (words[p + 1] > 0)
+      out.insert(out.end(), (size_t)words[p + 1], words[p]);
+  return first_difference(out.data(), out.size(), histogram);
+}
+
+// Row id pair output (join_new_row_ids): every pair has to be in range and
+// join, i.e. a[row_a] == b[row_b], and no pair may appear twice. With that,
+// the right count means the output is exactly the set of matching pairs.
+struct PairVerifyResult {
+  bool equal = true;
+  // only valid if !equal, index == n_out for a count mismatch
+  size_t index = 0;
+  uint32_t pair = 0;
+  size_t expected = 0;
+  size_t got = 0;
+};
+
+// Shared by the pair and the triple check: ok(i) tells if output i joins,
+// id(i) is a 64 bit (row_a, row_b) identity used to find repeated outputs.
+template <typename Ok, typename Id>
+PairVerifyResult verify_unique_rows(size_t n_out, size_t expected, Ok ok, Id id,
+                                    unsigned n_threads) {
+  PairVerifyResult res;
+  res.expected = expected;
+  res.got = n_out;
+
+  n_threads = std::max(1u, std::min<unsigned>(n_threads, (unsigned)(n_out / 65536 + 1)));
+  std::vector<size_t> first_bad(n_threads, n_out);
+  std::vector<uint64_t> ids(n_out);
+  parallel_for_range(n_out, n_threads, [&](unsigned t, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (!ok(i)) {
+        first_bad[t] = i;
+        return;
+      }
+      ids[i] = id(i);
+    }
+  });
+  for (size_t i : first_bad)
+    if (i < n_out) {
+      res.equal = false;
+      res.index = i;
+      return res;
+    }
+
+  std::vector<uint64_t> sorted = ids;
+  std::sort(sorted.begin(), sorted.end());
+  auto dup = std::adjacent_find(sorted.begin(), sorted.end());
+  if (dup != sorted.end()) {
+    res.equal = false;
+    res.index = std::find(ids.begin(), ids.end(), *dup) - ids.begin();
+    return res;
+  }
+
+  if (n_out != expected) {
+    res.equal = false;
+    res.index = n_out;
+  }
+  return res;
+}
+
+template <typename T>
+PairVerifyResult verify_row_id_pairs(const uint32_t *pairs, size_t n_out,
+                                     const T *a, size_t n_a, const T *b,
+                                     size_t n_b, size_t expected,
+                                     unsigned n_threads = default_join_threads()) {
+  PairVerifyResult res = verify_unique_rows(
+      n_out, expected,
+      [&](size_t i) {
+        size_t ra = pairs[i] >> 16, rb = pairs[i] & 0xFFFF;
+        return ra < n_a && rb < n_b && a[ra] == b[rb];
+      },
+      [&](size_t i) { return (uint64_t)pairs[i]; }, n_threads);
+  if (!res.equal && res.index < n_out)
+    res.pair = pairs[res.index];
+  return res;
+}
+
+// Key + payload output (join_new_payload): n_out (key, payload_a, payload_b)
+// triples. The harness uses the row number as payload, so a triple is right
+// iff a[payload_a] == b[payload_b] == key.
+template <typename T>
+PairVerifyResult verify_row_triples(const T *triples, size_t n_out, const T *a,
+                                    size_t n_a, const T *b, size_t n_b,
+                                    size_t expected,
+                                    unsigned n_threads = default_join_threads()) {
+  return verify_unique_rows(
+      n_out, expected,
+      [&](size_t i) {
+        const T *t = triples + 3 * i;
+        uint64_t ra = (uint64_t)t[1], rb = (uint64_t)t[2];
+        return ra < n_a && rb < n_b && a[ra] == t[0] && b[rb] == t[0];
+      },
+      [&](size_t i) {
+        return ((uint64_t)(uint32_t)triples[3 * i + 1] << 32) |
+               (uint32_t)triples[3 * i + 2];
+      },
+      n_threads);
+}
+
+// Semi / anti join bitmap (semi_join.h) against the reference bitmap. A
+// differing word is resolved to the first row whose bit differs, index is
+// that row, expected / got its bit. Padding bits of the last tile count too.
+inline PairVerifyResult verify_bitmap(const uint32_t *bitmap,
+                                      const uint32_t *expected, size_t n_words) {
+  PairVerifyResult res;
+  res.expected = res.got = n_words;
+  auto bad = std::mismatch(bitmap, bitmap + n_words, expected);
+  if (bad.first == bitmap + n_words)
+    return res;
+  size_t w = bad.first - bitmap;
+  uint32_t diff = *bad.first ^ *bad.second;
+  size_t bit = 0;
+  while (!((diff >> bit) & 1))
+    bit++;
+  res.equal = false;
+  res.index = w * 32 + bit;
+  res.expected = (*bad.second >> bit) & 1;
+  res.got = (*bad.first >> bit) & 1;
+  return res;
+}
+
+} // namespace join_utils
+
+#endif
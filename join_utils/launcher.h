@@ -0,0 +1,289 @@
+//===- launcher.h -----------------------------------------------*- C++ -*-===//
+//
+// Launch queue with a buffer pool for many small launches of one design.
+//
+// BufferPool keeps allocated (and mapped) buffers keyed by size and kernel
+// argument (group id), a launch takes what it needs and gives it back when
+// it is collected, so after warm up no launch allocates or maps a BO.
+//
+// Launcher::submit(fill, collect) takes one buffer per argument of the
+// layout, lets fill write and sync the inputs on the calling thread, starts
+// the design and returns a future. A completion thread waits for the runs
+// in submission order, calls collect(buffers, completed) and fulfils the
+// future with its result. At most max_in_flight launches are queued, submit
+// blocks while the queue is full. Combined with the xrt::run reuse of
+// XrtBackend a launch costs a few set_arg calls and a start.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_LAUNCHER_H
+#define JOIN_UTILS_LAUNCHER_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "exec_backend.h"
+
+namespace join_utils {
+
+class BufferPool {
+public:
+  explicit BufferPool(ExecBackend &backend) : backend_(backend) {}
+
+  // a free buffer of exactly bytes for arg_index, allocated if there is none
+  std::unique_ptr<Buffer> take(size_t bytes, int arg_index) {
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      auto it = free_.find({bytes, arg_index});
+      if (it != free_.end() && !it->second.empty()) {
+        std::unique_ptr<Buffer> b = std::move(it->second.back());
+        it->second.pop_back();
+        reused_++;
+        return b;
+      }
+      allocated_++;
+    }
+    std::unique_ptr<Buffer> b = backend_.alloc(bytes, arg_index);
+    // map up front, XRT maps on first use otherwise
+    b->map();
+    return b;
+  }
+
+  void give(std::unique_ptr<Buffer> b, int arg_index) {
+    std::lock_guard<std::mutex> lk(m_);
+    free_[{b->size(), arg_index}].push_back(std::move(b));
+  }
+
+  // allocates up to count free buffers of this key ahead of the first launch
+  void reserve(size_t bytes, int arg_index, size_t count) {
+    std::vector<std::unique_ptr<Buffer>> fresh;
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      size_t have = free_[{bytes, arg_index}].size();
+      count = count > have ? count - have : 0;
+      allocated_ += count;
+    }
+    for (size_t i = 0; i < count; i++) {
+      fresh.push_back(backend_.alloc(bytes, arg_index));
+      fresh.back()->map();
+    }
+    std::lock_guard<std::mutex> lk(m_);
+    for (auto &b : fresh)
+      free_[{bytes, arg_index}].push_back(std::move(b));
+  }
+
+  size_t allocated() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return allocated_;
+  }
+  size_t reused() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return reused_;
+  }
+
+private:
+  ExecBackend &backend_;
+  mutable std::mutex m_;
+  std::map<std::pair<size_t, int>, std::vector<std::unique_ptr<Buffer>>> free_;
+  size_t allocated_ = 0;
+  size_t reused_ = 0;
+};
+
+// one kernel argument of a launch, arg_index as for ExecBackend::alloc
+struct LaunchArg {
+  size_t bytes;
+  int arg_index;
+};
+
+struct LauncherStats {
+  size_t launches = 0;
+  size_t failed = 0;
+  size_t buffers_allocated = 0;
+  size_t buffers_reused = 0;
+  // time submit and wait_idle blocked on the queue
+  double blocked_seconds = 0;
+};
+
+class Launcher {
+public:
+  using Buffers = std::vector<Buffer *>;
+
+  Launcher(ExecBackend &backend, std::vector<LaunchArg> layout,
+           unsigned max_in_flight = 2)
+      : backend_(backend), pool_(backend), layout_(std::move(layout)),
+        max_in_flight_(std::max(1u, max_in_flight)),
+        completer_([this]() { complete_loop(); }) {}
+
+  ~Launcher() {
+    wait_idle();
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    completer_.join();
+  }
+
+  Launcher(const Launcher &) = delete;
+  Launcher &operator=(const Launcher &) = delete;
+
+  BufferPool &pool() { return pool_; }
+
+  // buffers for count launches of the default layout
+  void reserve(size_t count) {
+    for (auto &a : layout_)
+      pool_.reserve(a.bytes, a.arg_index, count);
+  }
+
+  template <typename Fill, typename Collect>
+  auto submit(Fill &&fill, Collect &&collect) {
+    return submit(layout_, std::forward<Fill>(fill), std::forward<Collect>(collect));
+  }
+
+  // fill(buffers) before the start, collect(buffers, completed) after it
+  template <typename Fill, typename Collect>
+  auto submit(const std::vector<LaunchArg> &layout, Fill &&fill, Collect &&collect)
+      -> std::future<std::invoke_result_t<Collect &, const Buffers &, bool>> {
+    using R = std::invoke_result_t<Collect &, const Buffers &, bool>;
+    {
+      auto t0 = std::chrono::high_resolution_clock::now();
+      std::unique_lock<std::mutex> lk(m_);
+      cv_.wait(lk, [this]() { return in_flight_ < max_in_flight_; });
+      in_flight_++;
+      stats_.blocked_seconds += std::chrono::duration<double>(
+                                    std::chrono::high_resolution_clock::now() - t0)
+                                    .count();
+    }
+
+    auto pending = std::make_unique<Pending>();
+    Buffers args;
+    try {
+      for (auto &a : layout) {
+        pending->buffers.push_back(pool_.take(a.bytes, a.arg_index));
+        pending->arg_index.push_back(a.arg_index);
+        args.push_back(pending->buffers.back().get());
+      }
+      fill(args);
+      pending->run = backend_.start(args);
+    } catch (...) {
+      release(*pending);
+      throw;
+    }
+
+    auto promise = std::make_shared<std::promise<R>>();
+    std::future<R> result = promise->get_future();
+    pending->complete = [promise, collect = std::forward<Collect>(collect)](
+                            const Buffers &b, bool completed) mutable {
+      try {
+        if constexpr (std::is_void_v<R>) {
+          collect(b, completed);
+          promise->set_value();
+        } else {
+          promise->set_value(collect(b, completed));
+        }
+      } catch (...) {
+        promise->set_exception(std::current_exception());
+      }
+    };
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      queue_.push_back(std::move(pending));
+      stats_.launches++;
+    }
+    cv_.notify_all();
+    return result;
+  }
+
+  // blocks until every submitted launch is collected
+  void wait_idle() {
+    auto t0 = std::chrono::high_resolution_clock::now();
+    std::unique_lock<std::mutex> lk(m_);
+    cv_.wait(lk, [this]() { return in_flight_ == 0; });
+    stats_.blocked_seconds += std::chrono::duration<double>(
+                                  std::chrono::high_resolution_clock::now() - t0)
+                                  .count();
+  }
+
+  LauncherStats stats() const {
+    std::lock_guard<std::mutex> lk(m_);
+    LauncherStats s = stats_;
+    s.buffers_allocated = pool_.allocated();
+    s.buffers_reused = pool_.reused();
+    return s;
+  }
+
+private:
+  struct Pending {
+    std::unique_ptr<Run> run;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    std::vector<int> arg_index;
+    std::function<void(const Buffers &, bool)> complete;
+  };
+
+  // buffers back to the pool, one less in flight
+  void release(Pending &p) {
+    for (size_t i = 0; i < p.buffers.size(); i++)
+      pool_.give(std::move(p.buffers[i]), p.arg_index[i]);
+    p.buffers.clear();
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      in_flight_--;
+    }
+    cv_.notify_all();
+  }
+
+  void complete_loop() {
+    for (;;) {
+      std::unique_ptr<Pending> p;
+      {
+        std::unique_lock<std::mutex> lk(m_);
+        cv_.wait(lk, [this]() { return stop_ || !queue_.empty(); });
+        if (queue_.empty())
+          return;
+        p = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      bool completed = p->run->wait();
+      p->run.reset();
+      Buffers args;
+      for (auto &b : p->buffers)
+        args.push_back(b.get());
+      p->complete(args, completed);
+      if (!completed) {
+        std::lock_guard<std::mutex> lk(m_);
+        stats_.failed++;
+      }
+      release(*p);
+    }
+  }
+
+  ExecBackend &backend_;
+  BufferPool pool_;
+  std::vector<LaunchArg> layout_;
+  unsigned max_in_flight_;
+  mutable std::mutex m_;
+  std::condition_variable cv_;
+  std::deque<std::unique_ptr<Pending>> queue_;
+  unsigned in_flight_ = 0;
+  bool stop_ = false;
+  LauncherStats stats_;
+  // last member, the thread starts after everything above is constructed
+  std::thread completer_;
+};
+
+} // namespace join_utils
+
+#endif
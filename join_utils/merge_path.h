@@ -0,0 +1,150 @@
+//===- merge_path.h ---------------------------------------------*- C++ -*-===//
+//
+// Host side of the sort-merge NPU join (join_new_sort_merge).
+//
+// Both relations are sorted with parallel_sort. Then a merge path walk over
+// the tile zone maps lists the (outer, inner) tile pairs whose key ranges
+// overlap. With few duplicates there are about tiles_a + tiles_b of them
+// instead of tiles_a * tiles_b. The runtime sequence of the design is
+// static, so it moves a fixed number of pair slots (pair_steps). The host
+// writes the two tiles of pair k into slot k of the two device streams and
+// fills the unused slots with pads. Pairs that do not fit the slots are
+// joined on the host with join_tile_pairs.
+//
+// Pads sort after every real key: merge_pad_a for A, merge_pad_b for B.
+// They never match each other, so keys must stay below merge_pad_b
+// (merge_keys_fit).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_MERGE_PATH_H
+#define JOIN_UTILS_MERGE_PATH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "hash_join.h"
+#include "zone_map.h"
+
+namespace join_utils {
+
+template <typename T> constexpr T merge_pad_a() {
+  return std::numeric_limits<T>::max();
+}
+template <typename T> constexpr T merge_pad_b() {
+  return std::numeric_limits<T>::max() - 1;
+}
+
+template <typename T> bool merge_keys_fit(const T *keys, size_t n) {
+  return n == 0 || *std::max_element(keys, keys + n) < merge_pad_b<T>();
+}
+
+// Sorts chunks on every thread, then merges neighbouring runs in parallel
+// rounds until one run is left.
+template <typename T>
+void parallel_sort(T *v, size_t n, unsigned n_threads = default_join_threads()) {
+  n_threads = std::max(1u, std::min<unsigned>(n_threads, (unsigned)(n / 65536 + 1)));
+  size_t run = (n + n_threads - 1) / n_threads;
+  if (run == 0)
+    return;
+  parallel_for_range(n, n_threads, [&](unsigned, size_t begin, size_t end) {
+    std::sort(v + begin, v + end);
+  });
+  for (; run < n; run *= 2) {
+    size_t merges = (n + 2 * run - 1) / (2 * run);
+    parallel_for_range(merges, n_threads, [&](unsigned, size_t begin, size_t end) {
+      for (size_t m = begin; m < end; m++) {
+        size_t lo = m * 2 * run;
+        size_t mid = std::min(n, lo + run), hi = std::min(n, lo + 2 * run);
+        std::inplace_merge(v + lo, v + mid, v + hi);
+      }
+    });
+  }
+}
+
+struct TilePair {
+  uint32_t outer;
+  uint32_t inner;
+};
+
+// All (outer, inner) tile pairs of the sorted a and b with overlapping key
+// ranges, outer major. The first inner tile that can still overlap only
+// moves up, so this is a single merge over the two zone maps.
+template <typename T>
+std::vector<TilePair> merge_tile_pairs(const T *a, size_t n_a, const T *b,
+                                       size_t n_b, size_t tile_elements = 64) {
+  std::vector<Zone<T>> za = zone_maps(a, n_a, tile_elements);
+  std::vector<Zone<T>> zb = zone_maps(b, n_b, tile_elements);
+  std::vector<TilePair> pairs;
+  pairs.reserve(za.size() + zb.size());
+  size_t lo = 0;
+  for (size_t i = 0; i < za.size(); i++) {
+    while (lo < zb.size() && zb[lo].max < za[i].min)
+      lo++;
+    for (size_t j = lo; j < zb.size() && zb[j].min <= za[i].max; j++)
+      pairs.push_back({(uint32_t)i, (uint32_t)j});
+  }
+  return pairs;
+}
+
+// Writes the tiles of pairs[0 .. slots) into the device streams dev_a /
+// dev_b (slots * tile_elements each), partial tiles and unused slots padded.
+// Returns the number of pairs that got a slot.
+template <typename T>
+size_t fill_merge_streams(const T *a, size_t n_a, const T *b, size_t n_b,
+                          const std::vector<TilePair> &pairs, size_t slots,
+                          T *dev_a, T *dev_b, size_t tile_elements = 64,
+                          unsigned n_threads = default_join_threads()) {
+  size_t placed = std::min(pairs.size(), slots);
+  auto copy_tile = [tile_elements](const T *src, size_t n, size_t t, T pad,
+                                   T *dst) {
+    size_t begin = std::min(n, t * tile_elements);
+    size_t end = std::min(n, begin + tile_elements);
+    std::copy(src + begin, src + end, dst);
+    std::fill(dst + (end - begin), dst + tile_elements, pad);
+  };
+  n_threads = std::max(1u, std::min<unsigned>(n_threads, (unsigned)(slots / 1024 + 1)));
+  parallel_for_range(slots, n_threads, [&](unsigned, size_t begin, size_t end) {
+    for (size_t k = begin; k < end; k++) {
+      T *slot_a = dev_a + k * tile_elements;
+      T *slot_b = dev_b + k * tile_elements;
+      if (k < placed) {
+        copy_tile(a, n_a, pairs[k].outer, merge_pad_a<T>(), slot_a);
+        copy_tile(b, n_b, pairs[k].inner, merge_pad_b<T>(), slot_b);
+      } else {
+        std::fill(slot_a, slot_a + tile_elements, merge_pad_a<T>());
+        std::fill(slot_b, slot_b + tile_elements, merge_pad_b<T>());
+      }
+    }
+  });
+  return placed;
+}
+
+// Joins pairs[first ..) on the host, one key per match like the kernel.
+template <typename T>
+std::vector<T> join_tile_pairs(const T *a, size_t n_a, const T *b, size_t n_b,
+                               const std::vector<TilePair> &pairs, size_t first,
+                               size_t tile_elements = 64) {
+  std::vector<T> out;
+  for (size_t k = first; k < pairs.size(); k++) {
+    size_t a_begin = pairs[k].outer * tile_elements;
+    size_t a_end = std::min(n_a, a_begin + tile_elements);
+    size_t b_begin = pairs[k].inner * tile_elements;
+    size_t b_end = std::min(n_b, b_begin + tile_elements);
+    size_t j0 = b_begin;
+    for (size_t i = a_begin; i < a_end; i++) {
+      while (j0 < b_end && b[j0] < a[i])
+        j0++;
+      for (size_t j = j0; j < b_end && b[j] == a[i]; j++)
+        out.push_back(b[j]);
+    }
+  }
+  return out;
+}
+
+} // namespace join_utils
+
+#endif
@@ -0,0 +1,152 @@
+//===- npu_partition.h ------------------------------------------*- C++ -*-===//
+//
+// Host side of the partitioned NPU join (join_new_partitioned).
+//
+// Both relations are radix partitioned with the same bits as the host hash
+// join, then every partition is copied into a fixed capacity slot of the
+// device buffer and padded up with a sentinel. A pads with pad_a, B with
+// pad_b != pad_a, so pads never produce a match. The design only joins slot
+// p of A with slot p of B.
+//
+// A partition index is handed to the host instead when it does not fit the
+// slot in either relation, or when a real key equals one of the sentinels;
+// its NPU slots are then filled with pads only, and the caller joins it on
+// the host.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_NPU_PARTITION_H
+#define JOIN_UTILS_NPU_PARTITION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "hash_join.h"
+
+namespace join_utils {
+
+template <typename T> constexpr T npu_pad_a() {
+  return std::numeric_limits<T>::min();
+}
+template <typename T> constexpr T npu_pad_b() {
+  return std::numeric_limits<T>::min() + 1;
+}
+
+struct PartitionLayout {
+  unsigned radix_bits = 0;
+  size_t n_parts = 1;
+  // elements per slot, a multiple of the 64 element kernel tile
+  size_t capacity = 0;
+  size_t elements() const { return n_parts * capacity; }
+};
+
+// Same rule as aie2.py: the fewest partitions (power of two) such that the
+// slots hold twice the relation, i.e. a uniform partition fills half a slot.
+inline PartitionLayout partition_layout(size_t host_elements,
+                                        size_t part_elements) {
+  PartitionLayout l;
+  l.capacity = part_elements;
+  while (l.n_parts * part_elements < 2 * host_elements) {
+    l.n_parts <<= 1;
+    l.radix_bits++;
+  }
+  return l;
+}
+
+inline size_t partition_of(uint64_t key, unsigned radix_bits) {
+  return mix_key(key) & ((size_t(1) << radix_bits) - 1);
+}
+
+template <typename T> struct NpuPartitions {
+  Partitioned<T> a;
+  Partitioned<T> b;
+  // 1 if the partition is joined on the host
+  std::vector<char> on_host;
+  size_t n_on_host = 0;
+};
+
+// Partitions a and b and writes the padded slots into dev_a / dev_b, each
+// layout.elements() long.
+template <typename T>
+NpuPartitions<T> partition_for_npu(const T *a, size_t n_a, const T *b,
+                                   size_t n_b, const PartitionLayout &layout,
+                                   T *dev_a, T *dev_b,
+                                   unsigned n_threads = default_join_threads()) {
+  NpuPartitions<T> res;
+  res.a = radix_partition(a, n_a, layout.radix_bits, n_threads);
+  res.b = radix_partition(b, n_b, layout.radix_bits, n_threads);
+  res.on_host.assign(layout.n_parts, 0);
+
+  const T pad_a = npu_pad_a<T>(), pad_b = npu_pad_b<T>();
+  auto size_of = [](const Partitioned<T> &p, size_t i) {
+    return p.part_begin[i + 1] - p.part_begin[i];
+  };
+  auto has_pad = [&](const Partitioned<T> &p, size_t i) {
+    for (size_t k = p.part_begin[i]; k < p.part_begin[i + 1]; k++)
+      if (p.out[k] == pad_a || p.out[k] == pad_b)
+        return true;
+    return false;
+  };
+
+  parallel_for_range(layout.n_parts, n_threads,
+                     [&](unsigned, size_t begin, size_t end) {
+    for (size_t p = begin; p < end; p++) {
+      size_t na = size_of(res.a, p), nb = size_of(res.b, p);
+      bool host = na > layout.capacity || nb > layout.capacity ||
+                  has_pad(res.a, p) || has_pad(res.b, p);
+      res.on_host[p] = host;
+      if (host)
+        na = nb = 0;
+
+      T *slot_a = dev_a + p * layout.capacity;
+      T *slot_b = dev_b + p * layout.capacity;
+      std::copy_n(res.a.out.data() + res.a.part_begin[p], na, slot_a);
+      std::fill(slot_a + na, slot_a + layout.capacity, pad_a);
+      std::copy_n(res.b.out.data() + res.b.part_begin[p], nb, slot_b);
+      std::fill(slot_b + nb, slot_b + layout.capacity, pad_b);
+    }
+  });
+
+  for (char h : res.on_host)
+    res.n_on_host += h;
+  return res;
+}
+
+// Joins the partitions the NPU did not get.
+template <typename T>
+JoinResult<T> join_host_partitions(const NpuPartitions<T> &parts,
+                                   bool want_matches = true,
+                                   unsigned n_threads = default_join_threads()) {
+  std::vector<T> a, b;
+  for (size_t p = 0; p < parts.on_host.size(); p++) {
+    if (!parts.on_host[p])
+      continue;
+    a.insert(a.end(), parts.a.out.begin() + parts.a.part_begin[p],
+             parts.a.out.begin() + parts.a.part_begin[p + 1]);
+    b.insert(b.end(), parts.b.out.begin() + parts.b.part_begin[p],
+             parts.b.out.begin() + parts.b.part_begin[p + 1]);
+  }
+  return radix_hash_join(a.data(), a.size(), b.data(), b.size(), want_matches,
+                         n_threads);
+}
+
+// The part of a reference histogram the NPU is expected to produce.
+template <typename T>
+std::vector<std::pair<T, size_t>>
+npu_histogram(const std::vector<std::pair<T, size_t>> &histogram,
+              const NpuPartitions<T> &parts, unsigned radix_bits) {
+  std::vector<std::pair<T, size_t>> res;
+  res.reserve(histogram.size());
+  for (auto &kv : histogram)
+    if (!parts.on_host[partition_of((uint64_t)kv.first, radix_bits)])
+      res.push_back(kv);
+  return res;
+}
+
+} // namespace join_utils
+
+#endif
@@ -0,0 +1,177 @@
+//===- pipeline.h -----------------------------------------------*- C++ -*-===//
+//
+// Pipelined multi-run driver for the join harnesses.
+//
+// Every iteration gets one of depth buffer sets (slots), iteration k uses
+// slot k % depth. While the design runs iteration k, iteration k + 1 is
+// already queued behind it, iteration k - 1 is synced back and verified on
+// a worker thread and the inputs of the next iteration are prepared on
+// another one. A slot is only prepared again after the finish of its last
+// iteration returned, so prepare and finish of one iteration never overlap.
+//
+// prepare calls run one after another in iteration order (they may share an
+// rng), finish calls of different iterations can run concurrently.
+// depth 1 is the plain serial loop: prepare, run, wait, finish.
+//
+// With depth > 1 every run is waited for on its own thread right after the
+// start, so its completion time does not depend on when the host gets to
+// the finish. The device runs the queued launches in order, the run time of
+// iteration k is taken from max(start k, completion k - 1) to completion k,
+// without the time it was queued behind k - 1.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_PIPELINE_H
+#define JOIN_UTILS_PIPELINE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "exec_backend.h"
+
+namespace join_utils {
+
+struct PipelineStats {
+  size_t iterations = 0;
+  size_t failed = 0;
+  double seconds = 0;
+  // start (or completion of the previous run, if later) to completion per
+  // iteration
+  std::vector<double> run_seconds;
+};
+
+class RunPipeline {
+public:
+  using Buffers = std::vector<Buffer *>;
+  // allocates the kernel argument buffers of one slot
+  using Alloc = std::function<std::vector<std::unique_ptr<Buffer>>(ExecBackend &)>;
+  // writes and syncs the inputs of iteration iter into the slot buffers
+  using Prepare = std::function<void(size_t iter, const Buffers &)>;
+  // syncs back and checks iteration iter, false counts as failed
+  using Finish = std::function<bool(size_t iter, const Buffers &, bool completed,
+                                    double run_seconds)>;
+
+  RunPipeline(ExecBackend &backend, unsigned depth, const Alloc &alloc)
+      : backend_(backend), depth_(std::max(1u, depth)) {
+    for (unsigned s = 0; s < depth_; s++)
+      slots_.push_back(alloc(backend_));
+  }
+
+  unsigned depth() const { return depth_; }
+  // buffers of slot s, e.g. to map them once up front
+  Buffers buffers(unsigned s) const { return args(s); }
+
+  PipelineStats run(size_t n_iterations, const Prepare &prepare,
+                    const Finish &finish) {
+    PipelineStats stats;
+    stats.iterations = n_iterations;
+    stats.run_seconds.assign(n_iterations, 0);
+    auto start = std::chrono::high_resolution_clock::now();
+    if (depth_ == 1)
+      run_serial(n_iterations, prepare, finish, stats);
+    else
+      run_pipelined(n_iterations, prepare, finish, stats);
+    stats.seconds = std::chrono::duration<double>(
+                        std::chrono::high_resolution_clock::now() - start)
+                        .count();
+    return stats;
+  }
+
+private:
+  using clock = std::chrono::high_resolution_clock;
+
+  Buffers args(size_t s) const {
+    Buffers a;
+    for (auto &b : slots_[s])
+      a.push_back(b.get());
+    return a;
+  }
+
+  void run_serial(size_t n, const Prepare &prepare, const Finish &finish,
+                  PipelineStats &stats) {
+    Buffers a = args(0);
+    for (size_t k = 0; k < n; k++) {
+      prepare(k, a);
+      auto t0 = clock::now();
+      bool completed = backend_.start(a)->wait();
+      stats.run_seconds[k] =
+          std::chrono::duration<double>(clock::now() - t0).count();
+      stats.failed += !finish(k, a, completed, stats.run_seconds[k]);
+    }
+  }
+
+  void run_pipelined(size_t n, const Prepare &prepare, const Finish &finish,
+                     PipelineStats &stats) {
+    // per slot: the prepare of its next iteration (carrying the result of
+    // the finish it waited for) and the finish of its last iteration
+    std::vector<std::future<bool>> prepared(depth_), finished(depth_);
+    std::vector<std::unique_ptr<Run>> runs(depth_);
+    // per slot: wait() of the running iteration on its own thread
+    std::vector<std::future<bool>> waited(depth_);
+    std::vector<clock::time_point> started(n), done(n);
+
+    auto launch_prepare = [&](size_t k) {
+      size_t s = k % depth_;
+      prepared[s] = std::async(
+          std::launch::async,
+          [&prepare, k, a = args(s), fin = std::move(finished[s])]() mutable {
+            bool ok = fin.valid() ? fin.get() : true;
+            prepare(k, a);
+            return ok;
+          });
+    };
+    auto launch_finish = [&](size_t k) {
+      size_t s = k % depth_;
+      bool completed = waited[s].get();
+      runs[s].reset();
+      // done[k - 1] was set before waited of k - 1 returned in the last call
+      clock::time_point from = started[k];
+      if (k > 0 && done[k - 1] > from)
+        from = done[k - 1];
+      double t = std::chrono::duration<double>(done[k] - from).count();
+      stats.run_seconds[k] = t;
+      finished[s] = std::async(std::launch::async,
+                               [&finish, k, a = args(s), completed, t]() {
+                                 return finish(k, a, completed, t);
+                               });
+    };
+
+    if (n > 0)
+      launch_prepare(0);
+    for (size_t k = 0; k < n; k++) {
+      size_t s = k % depth_;
+      // prepare k must be done before it runs, it also hands over the
+      // result of the finish that freed the slot
+      stats.failed += !prepared[s].get();
+      started[k] = clock::now();
+      runs[s] = backend_.start(args(s));
+      waited[s] = std::async(std::launch::async, [run = runs[s].get(), &done, k]() {
+        bool completed = run->wait();
+        done[k] = clock::now();
+        return completed;
+      });
+      if (k > 0)
+        launch_finish(k - 1);
+      if (k + 1 < n)
+        launch_prepare(k + 1);
+    }
+    if (n > 0)
+      launch_finish(n - 1);
+    for (auto &f : finished)
+      if (f.valid())
+        stats.failed += !f.get();
+  }
+
+  ExecBackend &backend_;
+  unsigned depth_;
+  std::vector<std::vector<std::unique_ptr<Buffer>>> slots_;
+};
+
+} // namespace join_utils
+
+#endif
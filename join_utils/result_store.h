@@ -0,0 +1,129 @@
+//===- result_store.h -------------------------------------------*- C++ -*-===//
+//
+// Growable join result buffer for the chunked driver (chunked_join.h).
+//
+// Results are appended into fixed size segments, so growing never copies
+// what is already stored and there is no single allocation of the whole
+// result. Once more than max_resident_bytes are held in memory, every
+// further full segment is written to an unnamed temporary file and only read
+// back (one segment at a time) by for_each_segment.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_RESULT_STORE_H
+#define JOIN_UTILS_RESULT_STORE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace join_utils {
+
+template <typename T> class ResultStore {
+public:
+  explicit ResultStore(size_t segment_elements = size_t(1) << 20,
+                       size_t max_resident_bytes = size_t(1) << 30)
+      : segment_elements_(std::max<size_t>(segment_elements, 1)),
+        max_resident_bytes_(max_resident_bytes) {}
+
+  ResultStore(const ResultStore &) = delete;
+  ResultStore &operator=(const ResultStore &) = delete;
+
+  void append(const T *values, size_t n) {
+    while (n > 0) {
+      if (tail_.size() == segment_elements_)
+        seal_tail();
+      if (tail_.capacity() < segment_elements_)
+        tail_.reserve(segment_elements_);
+      size_t take = std::min(n, segment_elements_ - tail_.size());
+      tail_.insert(tail_.end(), values, values + take);
+      values += take;
+      n -= take;
+      size_ += take;
+    }
+  }
+
+  size_t size() const { return size_; }
+  size_t segments() const { return resident_.size() + spilled_ + (tail_.empty() ? 0 : 1); }
+  size_t spilled_bytes() const { return spilled_ * segment_elements_ * sizeof(T); }
+  size_t resident_bytes() const {
+    return (resident_.size() * segment_elements_ + tail_.size()) * sizeof(T);
+  }
+
+  // Calls fn(values, n) for every segment in append order: the resident
+  // ones, the spilled ones (read back into one scratch segment), the tail.
+  // Spilled segments always come after the resident ones, because a
+  // segment only spills once the resident budget is used up.
+  template <typename Fn> void for_each_segment(Fn &&fn) const {
+    for (auto &seg : resident_)
+      fn(seg.data(), seg.size());
+    if (spilled_ > 0) {
+      std::vector<T> scratch(segment_elements_);
+      std::rewind(file_.get());
+      for (size_t s = 0; s < spilled_; s++) {
+        if (std::fread(scratch.data(), sizeof(T), segment_elements_, file_.get()) !=
+            segment_elements_)
+          throw std::runtime_error("result store: short read from the spill file");
+        fn(scratch.data(), segment_elements_);
+      }
+      std::fseek(file_.get(), 0, SEEK_END);
+    }
+    if (!tail_.empty())
+      fn(tail_.data(), tail_.size());
+  }
+
+  // Only for results known to fit in memory.
+  std::vector<T> to_vector() const {
+    std::vector<T> out;
+    out.reserve(size_);
+    for_each_segment([&](const T *v, size_t n) { out.insert(out.end(), v, v + n); });
+    return out;
+  }
+
+  void clear() {
+    resident_.clear();
+    tail_.clear();
+    file_.reset();
+    spilled_ = 0;
+    size_ = 0;
+  }
+
+private:
+  struct FileClose {
+    void operator()(std::FILE *f) const { std::fclose(f); }
+  };
+
+  void seal_tail() {
+    size_t resident = (resident_.size() + 1) * segment_elements_ * sizeof(T);
+    if (resident <= max_resident_bytes_) {
+      resident_.push_back(std::move(tail_));
+    } else {
+      if (!file_) {
+        file_.reset(std::tmpfile());
+        if (!file_)
+          throw std::runtime_error("result store: cannot create a spill file");
+      }
+      if (std::fwrite(tail_.data(), sizeof(T), tail_.size(), file_.get()) !=
+          tail_.size())
+        throw std::runtime_error("result store: short write to the spill file");
+      spilled_++;
+    }
+    tail_ = std::vector<T>();
+  }
+
+  size_t segment_elements_;
+  size_t max_resident_bytes_;
+  std::vector<std::vector<T>> resident_;
+  std::vector<T> tail_;
+  std::unique_ptr<std::FILE, FileClose> file_;
+  size_t spilled_ = 0;
+  size_t size_ = 0;
+};
+
+} // namespace join_utils
+
+#endif
@@ -0,0 +1,125 @@
+//===- rle_decoder.h --------------------------------------------*- C++ -*-===//
+//
+// Run length encoded join output (join_new_rle, join_new_histogram with
+// expand=0): a word stream of (key, count) pairs, key repeated count times.
+//
+// RleRuns iterates the expanded keys lazily, so a consumer can walk the
+// result without materialising it; rle_decode expands into a buffer in
+// parallel when the whole result is needed.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_RLE_DECODER_H
+#define JOIN_UTILS_RLE_DECODER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "hash_join.h"
+
+namespace join_utils {
+
+template <typename T> class RleRuns {
+public:
+  // words holds n_words / 2 (key, count) pairs
+  RleRuns(const T *words, size_t n_words) : words_(words), n_runs_(n_words / 2) {}
+
+  class iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T *;
+    using reference = const T &;
+
+    iterator(const T *words, size_t run, size_t n_runs)
+        : words_(words), run_(run), n_runs_(n_runs) {
+      skip_empty();
+    }
+
+    const T &operator*() const { return words_[2 * run_]; }
+    iterator &operator++() {
+      if (++used_ >= (uint64_t)words_[2 * run_ + 1]) {
+        run_++;
+        used_ = 0;
+        skip_empty();
+      }
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator it = *this;
+      ++*this;
+      return it;
+    }
+    bool operator==(const iterator &o) const {
+      return run_ == o.run_ && used_ == o.used_;
+    }
+    bool operator!=(const iterator &o) const { return !(*this == o); }
+
+  private:
+    void skip_empty() {
+      while (run_ < n_runs_ && words_[2 * run_ + 1] <= 0)
+        run_++;
+    }
+
+    const T *words_;
+    size_t run_;
+    size_t n_runs_;
+    // copies of the current key already returned
+    uint64_t used_ = 0;
+  };
+
+  iterator begin() const { return iterator(words_, 0, n_runs_); }
+  iterator end() const { return iterator(words_, n_runs_, n_runs_); }
+
+  size_t runs() const { return n_runs_; }
+  T key(size_t run) const { return words_[2 * run]; }
+  uint64_t count(size_t run) const {
+    return words_[2 * run + 1] > 0 ? (uint64_t)words_[2 * run + 1] : 0;
+  }
+
+  // expanded length, i.e. the number of matches
+  uint64_t size() const {
+    uint64_t n = 0;
+    for (size_t r = 0; r < n_runs_; r++)
+      n += count(r);
+    return n;
+  }
+
+private:
+  const T *words_;
+  size_t n_runs_;
+};
+
+// Expands all runs, every thread writes the runs of its chunk at their
+// prefix sum offset.
+template <typename T>
+std::vector<T> rle_decode(const T *words, size_t n_words,
+                          unsigned n_threads = default_join_threads()) {
+  RleRuns<T> runs(words, n_words);
+  n_threads = std::max(1u, std::min<unsigned>(n_threads, (unsigned)(runs.runs() / 65536 + 1)));
+  std::vector<uint64_t> offset(n_threads + 1, 0);
+  parallel_for_range(runs.runs(), n_threads, [&](unsigned t, size_t begin, size_t end) {
+    uint64_t n = 0;
+    for (size_t r = begin; r < end; r++)
+      n += runs.count(r);
+    offset[t + 1] = n;
+  });
+  for (unsigned t = 0; t < n_threads; t++)
+    offset[t + 1] += offset[t];
+
+  std::vector<T> out(offset[n_threads]);
+  parallel_for_range(runs.runs(), n_threads, [&](unsigned t, size_t begin, size_t end) {
+    T *dst = out.data() + offset[t];
+    for (size_t r = begin; r < end; r++)
+      dst = std::fill_n(dst, runs.count(r), runs.key(r));
+  });
+  return out;
+}
+
+} // namespace join_utils
+
+#endif
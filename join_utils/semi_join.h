@@ -0,0 +1,75 @@
+//===- semi_join.h ----------------------------------------------*- C++ -*-===//
+//
+// Bitmap output of the semi / anti join design (join_new_semi): one bit per
+// row of A, two 32 bit words per 64 row tile, bit i of a tile is set iff
+// row i has a partner in B (semi) or has none (anti). Bits of the padding
+// rows of the last tile are always clear.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_SEMI_JOIN_H
+#define JOIN_UTILS_SEMI_JOIN_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "hash_join.h"
+
+namespace join_utils {
+
+constexpr size_t bitmap_tile_rows = 64;
+
+inline size_t bitmap_words(size_t n_rows) {
+  return (n_rows + bitmap_tile_rows - 1) / bitmap_tile_rows * 2;
+}
+
+inline bool bitmap_test(const uint32_t *bitmap, size_t row) {
+  return (bitmap[row / 32] >> (row % 32)) & 1;
+}
+
+// Reference bitmap, the keys of B are sorted once and every thread probes
+// a range of tiles of A.
+template <typename T>
+std::vector<uint32_t> semi_join_bitmap(const T *a, size_t n_a, const T *b,
+                                       size_t n_b, bool anti,
+                                       unsigned n_threads = default_join_threads()) {
+  std::vector<T> keys(b, b + n_b);
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+  std::vector<uint32_t> bitmap(bitmap_words(n_a), 0);
+  size_t tiles = bitmap.size() / 2;
+  n_threads = std::max(1u, std::min<unsigned>(n_threads, (unsigned)(tiles / 1024 + 1)));
+  parallel_for_range(tiles, n_threads, [&](unsigned, size_t begin, size_t end) {
+    for (size_t row = begin * bitmap_tile_rows;
+         row < std::min(n_a, end * bitmap_tile_rows); row++) {
+      bool found = std::binary_search(keys.begin(), keys.end(), a[row]);
+      if (found != anti)
+        bitmap[row / 32] |= 1u << (row % 32);
+    }
+  });
+  return bitmap;
+}
+
+inline uint64_t bitmap_count(const uint32_t *bitmap, size_t n_words) {
+  uint64_t n = 0;
+  for (size_t w = 0; w < n_words; w++)
+    n += std::popcount(bitmap[w]);
+  return n;
+}
+
+// Row ids of A with their bit set, in row order.
+inline std::vector<uint32_t> bitmap_rows(const uint32_t *bitmap, size_t n_rows) {
+  std::vector<uint32_t> rows;
+  for (size_t w = 0; w < (n_rows + 31) / 32; w++)
+    for (uint32_t bits = bitmap[w]; bits; bits &= bits - 1)
+      rows.push_back((uint32_t)(w * 32 + std::countr_zero(bits)));
+  return rows;
+}
+
+} // namespace join_utils
+
+#endif
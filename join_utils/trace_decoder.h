@@ -0,0 +1,334 @@
+//===- trace_decoder.h ------------------------------------------*- C++ -*-===//
+//
+// In-process decoder for the AIE2 packet trace buffer (trace_sz > 0), so a
+// sweep point can be profiled without writing the trace as text and running
+// parse.py / get_trace_summary.py.
+//
+// The buffer holds 8 word packets: a header (odd parity in bit 31, packet
+// type, source row and column) and 7 words of trace frames of that tile.
+// The frames of one tile are de-interleaved into a big endian byte stream
+// and decoded like parse.py does: Start (absolute timer), Single0/1/2 (one
+// event slot), Multiple0/1/2 (a mask of slots), Repeat0/1 (previous frame
+// again), filler and sync bytes. Each frame advances the timer by its cycle
+// delta plus one.
+//
+// Per tile, with the slots of TraceSlots (default: the core tile events of
+// configure_packet_tracing_aie2, event0 in slot 0, event1 in slot 1, lock
+// stall in slot 7):
+//   - an event0 .. event1 pair is one kernel invocation, its latencies
+//     go into a log2 histogram
+//   - lock stall frames are merged into stall intervals (the stall event
+//     fires every cycle the core is stalled)
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_TRACE_DECODER_H
+#define JOIN_UTILS_TRACE_DECODER_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace join_utils {
+
+struct TraceSlots {
+  int event0 = 0;
+  int event1 = 1;
+  int lock_stall = 7;
+};
+
+struct TraceTile {
+  // 0 core, 1 core memory, 2 shim, 3 mem tile
+  int type = 0;
+  int col = 0;
+  int row = 0;
+  uint64_t frames = 0;
+  // frames that could not be decoded, the rest of that packet was dropped
+  uint64_t bad_frames = 0;
+  std::array<uint64_t, 8> events{};
+  // event0 .. event1 latencies in cycles
+  std::vector<uint64_t> invocations;
+  uint64_t stall_cycles = 0;
+  uint64_t stall_intervals = 0;
+  uint64_t max_stall = 0;
+  // first to last timestamp, summed over the decoded runs
+  uint64_t traced_cycles = 0;
+};
+
+inline const char *trace_tile_type_name(int type) {
+  switch (type) {
+  case 0: return "core";
+  case 1: return "mem";
+  case 2: return "shim";
+  case 3: return "memtile";
+  }
+  return "unknown";
+}
+
+class TraceDecoder {
+public:
+  explicit TraceDecoder(TraceSlots slots = TraceSlots()) : slots_(slots) {}
+
+  // Decodes one trace buffer (one run) and adds it to the per tile totals.
+  // Returns the number of packets read.
+  size_t decode(const uint32_t *words, size_t n_words) {
+    std::map<Key, std::vector<uint8_t>> streams;
+    size_t packets = 0;
+    for (size_t i = 0; i < n_words;) {
+      uint32_t w = words[i];
+      if (w == 0 || !header_valid(w) || i + 8 > n_words) {
+        // unused tail of the buffer or not in sync with the packets
+        i++;
+        continue;
+      }
+      Key key{(int)((w >> 12) & 0x7), (int)((w >> 21) & 0x7F), (int)((w >> 16) & 0x1F)};
+      std::vector<uint8_t> &bytes = streams[key];
+      for (size_t j = 1; j < 8; j++)
+        for (int b = 3; b >= 0; b--)
+          bytes.push_back((uint8_t)(words[i + j] >> (8 * b)));
+      packets++;
+      i += 8;
+    }
+    for (auto &kv : streams) {
+      TraceTile &t = tiles_[kv.first];
+      std::tie(t.type, t.col, t.row) = kv.first;
+      decode_stream(kv.second, t);
+    }
+    return packets;
+  }
+
+  // tiles ordered by type, column, row
+  std::vector<TraceTile> tiles() const {
+    std::vector<TraceTile> out;
+    for (auto &kv : tiles_)
+      out.push_back(kv.second);
+    return out;
+  }
+
+  void clear() { tiles_.clear(); }
+
+  // core_names label the core tiles in column, row order (e.g. the cores
+  // of aie2.py left to right), other tiles are printed as type(col, row)
+  void print(std::ostream &os, const std::vector<std::string> &core_names = {}) const {
+    size_t core = 0;
+    for (auto &kv : tiles_) {
+      const TraceTile &t = kv.second;
+      os << trace_tile_type_name(t.type) << "(" << t.col << ", " << t.row << ")";
+      if (t.type == 0 && core < core_names.size())
+        os << " " << core_names[core];
+      if (t.type == 0)
+        core++;
+      os << ": " << t.frames << " frames, " << t.traced_cycles << " cycles traced";
+      if (t.bad_frames)
+        os << ", " << t.bad_frames << " undecodable";
+      os << "\n";
+      if (t.stall_intervals)
+        os << "  lock stalls: " << t.stall_intervals << " intervals, " << t.stall_cycles
+           << " cycles, longest " << t.max_stall << "\n";
+      print_latencies(os, t.invocations);
+    }
+  }
+
+private:
+  using Key = std::tuple<int, int, int>;
+
+  static bool header_valid(uint32_t w) {
+    // odd parity over the whole word, reserved bits zero
+    return (std::popcount(w) & 1) && ((w >> 5) & 0x7F) == 0 && ((w >> 15) & 1) == 0 &&
+           ((w >> 28) & 0x7) == 0;
+  }
+
+  // per stream decode state, the stream of one run starts closed
+  struct State {
+    uint64_t timer = 0;
+    bool started = false;
+    uint64_t first = 0;
+    bool in_call = false;
+    uint64_t call_start = 0;
+    bool stalled = false;
+    uint64_t stall_start = 0, stall_last = 0;
+  };
+
+  void frame(TraceTile &t, State &s, uint32_t mask, uint64_t cycles) {
+    s.timer += cycles + 1;
+    if (!s.started) {
+      s.started = true;
+      s.first = s.timer;
+    }
+    t.frames++;
+    for (int e = 0; e < 8; e++)
+      if ((mask >> e) & 1)
+        t.events[e]++;
+    if ((mask >> slots_.event0) & 1) {
+      s.in_call = true;
+      s.call_start = s.timer;
+    }
+    if (((mask >> slots_.event1) & 1) && s.in_call) {
+      t.invocations.push_back(s.timer - s.call_start);
+      s.in_call = false;
+    }
+    bool stall = (mask >> slots_.lock_stall) & 1;
+    if (stall && s.stalled && s.timer - s.stall_last <= 1) {
+      s.stall_last = s.timer;
+    } else {
+      close_stall(t, s);
+      if (stall) {
+        s.stalled = true;
+        s.stall_start = s.stall_last = s.timer;
+      }
+    }
+  }
+
+  static void close_stall(TraceTile &t, State &s) {
+    if (!s.stalled)
+      return;
+    uint64_t len = s.stall_last - s.stall_start + 1;
+    t.stall_cycles += len;
+    t.stall_intervals++;
+    t.max_stall = std::max(t.max_stall, len);
+    s.stalled = false;
+  }
+
+  void decode_stream(const std::vector<uint8_t> &b, TraceTile &t) {
+    State s;
+    uint32_t last_mask = 0;
+    uint64_t last_cycles = 0;
+    size_t n = b.size();
+    auto need = [&](size_t i, size_t k) { return i + k <= n; };
+    for (size_t i = 0; i < n;) {
+      // a zero word pads the end of a packet
+      if (i % 4 == 0 && need(i, 4) && !b[i] && !b[i + 1] && !b[i + 2] && !b[i + 3]) {
+        i += 4;
+        continue;
+      }
+      uint8_t c = b[i];
+      uint32_t mask = 0;
+      uint64_t cycles = 0;
+      size_t len = 0;
+      if ((c & 0xFB) == 0xF0) {
+        // Start, 56 bit timer
+        if (!need(i, 8))
+          break;
+        s.timer = 0;
+        for (int j = 1; j < 8; j++)
+          s.timer = (s.timer << 8) | b[i + j];
+        if (!s.started) {
+          s.started = true;
+          s.first = s.timer;
+        }
+        i += 8;
+        continue;
+      } else if ((c & 0xFC) == 0xDC) {
+        // not decoded by parse.py either
+        i += 4;
+        continue;
+      } else if ((c & 0x80) == 0x00) {
+        mask = 1u << ((c >> 4) & 0x7);
+        cycles = c & 0xF;
+        len = 1;
+      } else if ((c & 0xE0) == 0x80) {
+        if (!need(i, 2))
+          break;
+        mask = 1u << ((c >> 2) & 0x7);
+        cycles = ((uint64_t)(c & 0x3) << 8) | b[i + 1];
+        len = 2;
+      } else if ((c & 0xE0) == 0xA0) {
+        if (!need(i, 3))
+          break;
+        mask = 1u << ((c >> 2) & 0x7);
+        cycles = ((uint64_t)(c & 0x3) << 16) | ((uint64_t)b[i + 1] << 8) | b[i + 2];
+        len = 3;
+      } else if ((c & 0xF0) == 0xC0) {
+        if (!need(i, 2))
+          break;
+        mask = ((c & 0xF) << 4) | (b[i + 1] >> 4);
+        cycles = b[i + 1] & 0xF;
+        len = 2;
+      } else if ((c & 0xFC) == 0xD0) {
+        if (!need(i, 3))
+          break;
+        mask = ((c & 0x3) << 6) | (b[i + 1] >> 2);
+        cycles = ((uint64_t)(b[i + 1] & 0x3) << 8) | b[i + 2];
+        len = 3;
+      } else if ((c & 0xFC) == 0xD4) {
+        if (!need(i, 4))
+          break;
+        mask = ((c & 0x3) << 6) | (b[i + 1] >> 2);
+        cycles = ((uint64_t)(b[i + 1] & 0x3) << 16) | ((uint64_t)b[i + 2] << 8) | b[i + 3];
+        len = 4;
+      } else if ((c & 0xF0) == 0xE0 || (c & 0xFC) == 0xD8) {
+        // Repeat0 / Repeat1: the previous frame again
+        uint64_t repeats = c & 0xF;
+        len = 1;
+        if ((c & 0xFC) == 0xD8) {
+          if (!need(i, 2))
+            break;
+          repeats = ((uint64_t)(c & 0x3) << 8) | b[i + 1];
+          len = 2;
+        }
+        if (last_mask)
+          for (uint64_t r = 0; r < repeats; r++)
+            frame(t, s, last_mask, last_cycles);
+        i += len;
+        continue;
+      } else if (c == 0xFE || c == 0xFF) {
+        // filler, event sync
+        i++;
+        continue;
+      } else {
+        t.bad_frames++;
+        // skip to the next packet
+        i = (i / 28 + 1) * 28;
+        continue;
+      }
+      frame(t, s, mask, cycles);
+      last_mask = mask;
+      last_cycles = cycles;
+      i += len;
+    }
+    close_stall(t, s);
+    if (s.started)
+      t.traced_cycles += s.timer - s.first;
+  }
+
+  static void print_latencies(std::ostream &os, std::vector<uint64_t> lat) {
+    if (lat.empty())
+      return;
+    std::sort(lat.begin(), lat.end());
+    // nearest rank
+    auto pct = [&lat](double p) {
+      size_t rank = (size_t)std::ceil(p / 100.0 * lat.size());
+      return lat[std::min(lat.size(), std::max<size_t>(rank, 1)) - 1];
+    };
+    os << "  invocations: " << lat.size() << ", cycles min " << lat.front() << " p50 "
+       << pct(50) << " p90 " << pct(90) << " p99 " << pct(99) << " max " << lat.back()
+       << "\n";
+    // log2 buckets [2^k, 2^(k+1))
+    std::map<int, size_t> buckets;
+    for (uint64_t v : lat)
+      buckets[v ? 63 - std::countl_zero(v) : 0]++;
+    size_t most = 0;
+    for (auto &kv : buckets)
+      most = std::max(most, kv.second);
+    for (auto &kv : buckets) {
+      uint64_t lo = kv.first ? uint64_t(1) << kv.first : 0;
+      os << "    [" << lo << ", " << (uint64_t(1) << (kv.first + 1)) << "): " << kv.second
+         << " " << std::string((size_t)(40.0 * kv.second / most + 0.5), '#') << "\n";
+    }
+  }
+
+  TraceSlots slots_;
+  std::map<Key, TraceTile> tiles_;
+};
+
+} // namespace join_utils
+
+#endif
@@ -0,0 +1,233 @@
+//===- xrt_backend.h --------------------------------------------*- C++ -*-===//
+//
+// ExecBackend on top of XRT: loads the xclbin into an exclusive hardware
+// context, keeps the instruction BO and launches the design through an
+// xrt::run with the buffers bound after opcode, instructions and count.
+//
+// xrt::run objects are reused: a finished run goes back to an idle list and
+// the next start() takes the idle run that already has the most of its
+// buffers bound, so a relaunch over the same buffers is only run.start().
+// An idle run holds a handle to the BOs it was last bound to.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_XRT_BACKEND_H
+#define JOIN_UTILS_XRT_BACKEND_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "exec_backend.h"
+
+#include "xrt/xrt_bo.h"
+#include "xrt/xrt_device.h"
+#include "xrt/xrt_hw_context.h"
+#include "xrt/xrt_kernel.h"
+
+namespace join_utils {
+
+inline void xrt_load_kernel(xrt::device &device, xrt::hw_context &context,
+                            xrt::kernel &kernel, int verbosity,
+                            const std::string &xclbinFileName,
+                            const std::string &kernelNameInXclbin) {
+  // Get a device handle
+  unsigned int device_index = 0;
+  device = xrt::device(device_index);
+
+  // Load the xclbin
+  if (verbosity >= 1)
+    std::cout << "Loading xclbin: " << xclbinFileName << "\n";
+  auto xclbin = xrt::xclbin(xclbinFileName);
+
+  if (verbosity >= 1)
+    std::cout << "Kernel opcode: " << kernelNameInXclbin << "\n";
+
+  // Get the kernel from the xclbin
+  auto xkernels = xclbin.get_kernels();
+  auto xkernel =
+      *std::find_if(xkernels.begin(), xkernels.end(),
+                    [kernelNameInXclbin, verbosity](xrt::xclbin::kernel &k) {
+                      auto name = k.get_name();
+                      if (verbosity >= 1) {
+                        std::cout << "Name: " << name << std::endl;
+                      }
+                      return name.rfind(kernelNameInXclbin, 0) == 0;
+                    });
+  auto kernelName = xkernel.get_name();
+  // Register xclbin
+  if (verbosity >= 1)
+    std::cout << "Registering xclbin: " << xclbinFileName << "\n";
+
+  device.register_xclbin(xclbin);
+
+  // Get a hardware context
+  if (verbosity >= 1)
+    std::cout << "Getting hardware context.\n";
+  context = xrt::hw_context(device, xclbin.get_uuid(),
+                            xrt::hw_context::access_mode::exclusive);
+
+  // Get a kernel handle
+  if (verbosity >= 1)
+    std::cout << "Getting handle to kernel:" << kernelName << "\n";
+  kernel = xrt::kernel(context, kernelName);
+}
+
+class XrtBuffer : public Buffer {
+public:
+  XrtBuffer(xrt::device &device, size_t bytes, xrt::memory_group group)
+      : bo_(device, bytes, XRT_BO_FLAGS_HOST_ONLY, group), bytes_(bytes),
+        data_(bo_.map<void *>()) {}
+  void *map() override { return data_; }
+  size_t size() const override { return bytes_; }
+  void sync(SyncDir dir) override { bo_.sync(to_xrt(dir)); }
+  void sync(SyncDir dir, size_t bytes, size_t offset) override {
+    bo_.sync(to_xrt(dir), bytes, offset);
+  }
+  xrt::bo &bo() { return bo_; }
+
+private:
+  static xclBOSyncDirection to_xrt(SyncDir dir) {
+    return dir == SyncDir::ToDevice ? XCL_BO_SYNC_BO_TO_DEVICE
+                                    : XCL_BO_SYNC_BO_FROM_DEVICE;
+  }
+  xrt::bo bo_;
+  size_t bytes_;
+  void *data_;
+};
+
+class XrtBackend : public ExecBackend {
+public:
+  XrtBackend(int verbosity, const std::string &xclbin,
+             const std::string &kernel_name,
+             const std::vector<uint32_t> &instr_v, unsigned int opcode = 3)
+      : opcode_(opcode), instr_size_(instr_v.size()) {
+    xrt_load_kernel(device_, context_, kernel_, verbosity, xclbin,
+                    kernel_name);
+    bo_instr_ = xrt::bo(device_, instr_v.size() * sizeof(int),
+                        XCL_BO_FLAGS_CACHEABLE, kernel_.group_id(1));
+    void *bufInstr = bo_instr_.map<void *>();
+    std::memcpy(bufInstr, instr_v.data(), instr_v.size() * sizeof(int));
+    bo_instr_.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+  }
+
+  std::string name() const override { return "xrt"; }
+
+  std::unique_ptr<Buffer> alloc(size_t bytes, int arg_index) override {
+    return std::make_unique<XrtBuffer>(device_, bytes,
+                                       kernel_.group_id(arg_index));
+  }
+
+  std::unique_ptr<Run> start(const std::vector<Buffer *> &args) override {
+    std::unique_ptr<PooledRun> pooled = take_run(args);
+    for (size_t i = 0; i < args.size(); i++) {
+      xrt::bo &bo = static_cast<XrtBuffer *>(args[i])->bo();
+      if (i >= pooled->bound.size())
+        pooled->bound.resize(i + 1);
+      if (pooled->bound[i] && pooled->bound[i].address() == bo.address())
+        continue;
+      pooled->run.set_arg((int)(3 + i), bo);
+      pooled->bound[i] = bo;
+      set_args_++;
+    }
+    pooled->run.start();
+    starts_++;
+    return std::make_unique<XrtRun>(*this, std::move(pooled));
+  }
+
+  xrt::device &device() { return device_; }
+  xrt::kernel &kernel() { return kernel_; }
+
+  // xrt::run objects created and buffer arguments (re)bound so far
+  size_t runs_created() const { return runs_created_; }
+  size_t set_args() const { return set_args_; }
+  size_t starts() const { return starts_; }
+
+private:
+  struct PooledRun {
+    explicit PooledRun(xrt::kernel &kernel) : run(kernel) {}
+    xrt::run run;
+    // buffer arguments from index 3 on, kept alive so an address match is
+    // the same BO
+    std::vector<xrt::bo> bound;
+  };
+
+  // Returns the run to the idle list once it finished, a run that was
+  // never waited for is waited for here.
+  struct XrtRun : public Run {
+    XrtRun(XrtBackend &backend, std::unique_ptr<PooledRun> pooled)
+        : backend(backend), pooled(std::move(pooled)) {}
+    ~XrtRun() override {
+      if (!waited)
+        pooled->run.wait();
+      backend.give_run(std::move(pooled));
+    }
+    bool wait() override {
+      ert_cmd_state r = pooled->run.wait();
+      waited = true;
+      if (r != ERT_CMD_STATE_COMPLETED) {
+        std::cout << "run.wait() did not return ERT_CMD_STATE_COMPLETED: "
+                  << r << "\n";
+        return false;
+      }
+      return true;
+    }
+    XrtBackend &backend;
+    std::unique_ptr<PooledRun> pooled;
+    bool waited = false;
+  };
+
+  // idle run with the most matching bound buffers, a new one if none is idle
+  std::unique_ptr<PooledRun> take_run(const std::vector<Buffer *> &args) {
+    {
+      std::lock_guard<std::mutex> lk(runs_m_);
+      if (!idle_runs_.empty()) {
+        size_t best = 0, best_matches = 0;
+        for (size_t r = 0; r < idle_runs_.size(); r++) {
+          size_t matches = 0;
+          auto &bound = idle_runs_[r]->bound;
+          for (size_t i = 0; i < std::min(bound.size(), args.size()); i++)
+            matches += bound[i] && bound[i].address() ==
+                                       static_cast<XrtBuffer *>(args[i])->bo().address();
+          if (matches > best_matches || r == 0) {
+            best = r;
+            best_matches = matches;
+          }
+        }
+        std::unique_ptr<PooledRun> pooled = std::move(idle_runs_[best]);
+        idle_runs_.erase(idle_runs_.begin() + best);
+        return pooled;
+      }
+    }
+    auto pooled = std::make_unique<PooledRun>(kernel_);
+    pooled->run.set_arg(0, opcode_);
+    pooled->run.set_arg(1, bo_instr_);
+    pooled->run.set_arg(2, instr_size_);
+    runs_created_++;
+    return pooled;
+  }
+
+  void give_run(std::unique_ptr<PooledRun> pooled) {
+    std::lock_guard<std::mutex> lk(runs_m_);
+    idle_runs_.push_back(std::move(pooled));
+  }
+
+  unsigned int opcode_;
+  size_t instr_size_;
+  xrt::device device_;
+  xrt::hw_context context_;
+  xrt::kernel kernel_;
+  xrt::bo bo_instr_;
+  std::mutex runs_m_;
+  std::vector<std::unique_ptr<PooledRun>> idle_runs_;
+  std::atomic<size_t> runs_created_{0}, set_args_{0}, starts_{0};
+};
+
+} // namespace join_utils
+
+#endif
@@ -0,0 +1,65 @@
+//===- zone_map.h -----------------------------------------------*- C++ -*-===//
+//
+// Host side of the zone map tile skipping (join_new_zone_map): min / max
+// per kernel tile, and how many (outer, inner) tile pairs of two relations
+// have overlapping key ranges, i.e. how many odd_even calls the design
+// still makes.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef JOIN_UTILS_ZONE_MAP_H
+#define JOIN_UTILS_ZONE_MAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace join_utils {
+
+template <typename T> struct Zone {
+  T min;
+  T max;
+};
+
+// one zone per tile of tile_elements, the last tile may be partial
+template <typename T>
+std::vector<Zone<T>> zone_maps(const T *keys, size_t n, size_t tile_elements) {
+  std::vector<Zone<T>> zones;
+  zones.reserve((n + tile_elements - 1) / tile_elements);
+  for (size_t begin = 0; begin < n; begin += tile_elements) {
+    size_t end = std::min(n, begin + tile_elements);
+    auto mm = std::minmax_element(keys + begin, keys + end);
+    zones.push_back({*mm.first, *mm.second});
+  }
+  return zones;
+}
+
+// Number of pairs (a, b) with a.min <= b.max && b.min <= a.max. A b with
+// b.max < a.min also has b.min <= a.max, so per a the overlaps are
+// #(b.min <= a.max) - #(b.max < a.min).
+template <typename T>
+uint64_t overlapping_pairs(const std::vector<Zone<T>> &za,
+                           const std::vector<Zone<T>> &zb) {
+  std::vector<T> mins, maxs;
+  mins.reserve(zb.size());
+  maxs.reserve(zb.size());
+  for (auto &z : zb) {
+    mins.push_back(z.min);
+    maxs.push_back(z.max);
+  }
+  std::sort(mins.begin(), mins.end());
+  std::sort(maxs.begin(), maxs.end());
+
+  uint64_t pairs = 0;
+  for (auto &z : za) {
+    size_t starts = std::upper_bound(mins.begin(), mins.end(), z.max) - mins.begin();
+    size_t ends = std::lower_bound(maxs.begin(), maxs.end(), z.min) - maxs.begin();
+    pairs += starts - ends;
+  }
+  return pairs;
+}
+
+} // namespace join_utils
+
+#endif
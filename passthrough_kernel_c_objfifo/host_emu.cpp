@@ -0,0 +1,97 @@
+//===- host_emu.cpp ---------------------------------------------*- C++ -*-===//
+//
+// Runs passThroughLine() from kernel.cc on a host thread, fed and drained by
+// two more threads that stand in for the shim DMAs. Uses the host emulation
+// of aie_objectfifo.h in join_utils/host_aie.
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "host_locks.h"
+
+extern "C" {
+void passThroughLine(int32_t *in_buf0, int32_t *in_buf1, int32_t *out_buf0,
+                     int32_t *out_buf1, int64_t in_acq_lock,
+                     int64_t in_rel_lock, int64_t out_acq_lock,
+                     int64_t out_rel_lock);
+}
+
+int main() {
+  using host_aie::ObjectFifo;
+  using Port = ObjectFifo<int32_t>::Port;
+
+  // kernel.cc moves 8 lines of 1024 words
+  constexpr int LINES = 8;
+  constexpr int LINE = 1024;
+
+  std::vector<int32_t> in(LINES * LINE), out(LINES * LINE, 0);
+  for (int i = 0; i < LINES * LINE; i++)
+    in[i] = i;
+
+  ObjectFifo<int32_t> of_in("in", 2, LINE);
+  ObjectFifo<int32_t> of_out("out", 2, LINE);
+
+  std::string error;
+  std::thread shim_in([&]() {
+    try {
+      for (int l = 0; l < LINES; l++) {
+        std::memcpy(of_in.acquire(Port::Produce), &in[l * LINE],
+                    LINE * sizeof(int32_t));
+        of_in.release(Port::Produce);
+      }
+    } catch (const std::exception &e) {
+      error = e.what();
+      host_aie::LockTable::get().shutdown();
+    }
+  });
+  std::thread shim_out([&]() {
+    try {
+      for (int l = 0; l < LINES; l++) {
+        std::memcpy(&out[l * LINE], of_out.acquire(Port::Consume),
+                    LINE * sizeof(int32_t));
+        of_out.release(Port::Consume);
+      }
+    } catch (const std::exception &e) {
+      error = e.what();
+      host_aie::LockTable::get().shutdown();
+    }
+  });
+  std::thread core([&]() {
+    try {
+      passThroughLine(of_in.get_buffer(0), of_in.get_buffer(1),
+                      of_out.get_buffer(0), of_out.get_buffer(1),
+                      of_in.acq_lock(Port::Consume),
+                      of_in.rel_lock(Port::Consume),
+                      of_out.acq_lock(Port::Produce),
+                      of_out.rel_lock(Port::Produce));
+    } catch (const std::exception &e) {
+      error = e.what();
+      host_aie::LockTable::get().shutdown();
+    }
+  });
+  shim_in.join();
+  core.join();
+  shim_out.join();
+
+  int errors = 0;
+  if (!error.empty()) {
+    std::cout << "error: " << error << "\n";
+    errors++;
+  }
+  for (int i = 0; i < LINES * LINE; i++)
+    if (out[i] != in[i])
+      errors++;
+
+  if (!errors) {
+    std::cout << std::endl << "PASS!" << std::endl << std::endl;
+    return 0;
+  }
+  std::cout << std::endl << errors << " mismatches." << std::endl << std::endl;
+  std::cout << std::endl << "fail." << std::endl << std::endl;
+  return 1;
+}